@@ -0,0 +1,100 @@
+/*
+ * Native helpers for backend/src/snapshot_serializer.py.
+ *
+ * Writes the per-channel parts of the snapshot JSON straight from the aggregation engine's flat
+ * uint32 counter arrays. Loaded with ctypes; the serializer falls back to pure Python when the
+ * shared library has not been built (make backend-native).
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* USDT probes (provider "quicklook") with -DQL_USDT, see make backend-native-profile. */
+#if defined(QL_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define QL_PROBE2(name, a, b) DTRACE_PROBE2(quicklook, name, a, b)
+#else
+#warning "sys/sdt.h not found; USDT probes are compiled out"
+#endif
+#endif
+#ifndef QL_PROBE2
+#define QL_PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#endif
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static char *write_u32(char *p, uint32_t value) {
+    char digits[10];
+    int n = 0;
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        digits[n++] = digit_pairs[pair + 1];
+        digits[n++] = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        digits[n++] = digit_pairs[value * 2 + 1];
+        digits[n++] = digit_pairs[value * 2];
+    } else {
+        digits[n++] = (char)('0' + value);
+    }
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+/*
+ * For each channel in channels[0..count), writes `"ch":v` (bins == 1) or `"ch":[v0,...,vN]`
+ * (bins > 1), comma-separated, reading bins values at values[ch * bins]. When ends is not NULL,
+ * ends[i] receives the offset just past the i-th fragment, so callers can slice out single
+ * channels later. Returns the number of bytes written, or 0 when cap is too small.
+ */
+size_t ql_write_channel_values(const uint32_t *values, const int32_t *channels, size_t count,
+                               size_t bins, char *out, size_t cap, uint32_t *ends) {
+    size_t worst = count * (16 + bins * 11);
+    if (worst > cap) {
+        return 0;
+    }
+    QL_PROBE2(serialize_start, count, bins);
+    char *p = out;
+    for (size_t i = 0; i < count; i++) {
+        int32_t channel = channels[i];
+        if (i > 0) {
+            *p++ = ',';
+        }
+        *p++ = '"';
+        p = write_u32(p, (uint32_t)channel);
+        *p++ = '"';
+        *p++ = ':';
+        const uint32_t *row = values + (size_t)channel * bins;
+        if (bins == 1) {
+            p = write_u32(p, row[0]);
+        } else {
+            *p++ = '[';
+            for (size_t b = 0; b < bins; b++) {
+                if (b > 0) {
+                    *p++ = ',';
+                }
+                p = write_u32(p, row[b]);
+            }
+            *p++ = ']';
+        }
+        if (ends) {
+            ends[i] = (uint32_t)(p - out);
+        }
+    }
+    QL_PROBE2(serialize_end, count, (size_t)(p - out));
+    return (size_t)(p - out);
+}
@@ -0,0 +1,281 @@
+"""Checkpoint file for the aggregation engine, so a restarted backend continues where it stopped.
+
+Layout (little-endian): a fixed header, the flat u32 counter arrays as stored in
+`AggregationWindow` and its u64 per-channel ADC sums, the run-integrated u64 arrays of completed windows with their time range,
+the inter-arrival histograms with the last hit times and as last
+published, the fine rate ring, then three length-prefixed blobs: a small JSON document with the variable-length state
+(session settings, rate history, quality counters, notes) and the last published JSON and
+binary snapshots. Files are written to a temporary name and renamed into place, so a reader
+never sees a partial checkpoint.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import struct
+import sys
+from array import array
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+from .snapshot_serializer import HIST_BINS, HIST_NAMES, little_endian_bytes
+
+CHECKPOINT_MAGIC = b"QLC1"
+CHECKPOINT_VERSION = 6
+# magic, version, channels, max channels, running, window_s, sample_s, saved wall time (us),
+# t_start_us, t_end_us, sample_t_start_us, sample_t_end_us, t_offset_us
+CHECKPOINT_HEADER = struct.Struct("<4sHHHHIIqqqqqq")
+# run t_start_us, run t_end_us
+RUN_HEADER = struct.Struct("<qq")
+# inter-arrival bins, last hit on any channel (us)
+INTERVAL_HEADER = struct.Struct("<Iq")
+# published inter-arrival histograms present, their t_start_us, t_end_us
+LATEST_INTERVALS_HEADER = struct.Struct("<Bqq")
+# rate ring bin_us, bins, channels per bin (the session's, not max channels), newest absolute bin (-1 = empty)
+RATE_RING_HEADER = struct.Struct("<IIIq")
+BLOB_LENGTH = struct.Struct("<I")
+
+
+class CheckpointFormatError(ValueError):
+    pass
+
+
+@dataclass
+class Checkpoint:
+    channels: int
+    running: bool
+    window_s: int
+    sample_s: int
+    saved_at_us: int
+    t_start_us: int
+    t_end_us: int
+    sample_t_start_us: int
+    sample_t_end_us: int
+    t_offset_us: int
+    counts_by_channel: array
+    sample_counts_by_channel: array
+    hists: Dict[str, array]
+    adc_sums: Dict[str, array]
+    rate_history: List[List[float]]
+    rate_history_t_end_us: List[int]
+    quality: Dict[str, int]
+    notes: List[str]
+    run_t_start_us: int
+    run_t_end_us: int
+    run_counts_by_channel: array
+    run_hists: Dict[str, array]
+    dt_bins: int
+    hist_dt: array
+    hist_dt_global: array
+    last_hit_us: array
+    last_any_hit_us: int
+    # (t_start_us, t_end_us, per channel, global) as served by GET /intervals.
+    latest_intervals: Optional[Tuple[int, int, array, array]]
+    rate_bin_us: int
+    rate_bins: int
+    rate_channels: int
+    rate_last_bin: int
+    rate_counts: array
+    # SessionCreateRequest fields, so a non-default session can be recreated at startup.
+    session: Dict[str, object]
+    latest_snapshot: Optional[bytes] = None
+    latest_snapshot_binary: Optional[bytes] = None
+
+
+def encode_checkpoint(checkpoint: Checkpoint) -> bytes:
+    max_channels = len(checkpoint.counts_by_channel)
+    variable = {
+        "session": checkpoint.session,
+        "rate_history": checkpoint.rate_history,
+        "rate_history_t_end_us": checkpoint.rate_history_t_end_us,
+        "quality": checkpoint.quality,
+        "notes": checkpoint.notes,
+    }
+    parts = [
+        CHECKPOINT_HEADER.pack(
+            CHECKPOINT_MAGIC,
+            CHECKPOINT_VERSION,
+            checkpoint.channels,
+            max_channels,
+            int(checkpoint.running),
+            checkpoint.window_s,
+            checkpoint.sample_s,
+            checkpoint.saved_at_us,
+            checkpoint.t_start_us,
+            checkpoint.t_end_us,
+            checkpoint.sample_t_start_us,
+            checkpoint.sample_t_end_us,
+            checkpoint.t_offset_us,
+        ),
+        little_endian_bytes(checkpoint.counts_by_channel),
+        little_endian_bytes(checkpoint.sample_counts_by_channel),
+    ]
+    parts.extend(little_endian_bytes(checkpoint.hists[name]) for name in HIST_NAMES)
+    parts.extend(little_endian_bytes(checkpoint.adc_sums[name]) for name in HIST_NAMES)
+    parts.append(RUN_HEADER.pack(checkpoint.run_t_start_us, checkpoint.run_t_end_us))
+    parts.append(little_endian_bytes(checkpoint.run_counts_by_channel))
+    parts.extend(little_endian_bytes(checkpoint.run_hists[name]) for name in HIST_NAMES)
+    parts.append(INTERVAL_HEADER.pack(checkpoint.dt_bins, checkpoint.last_any_hit_us))
+    parts.append(little_endian_bytes(checkpoint.hist_dt))
+    parts.append(little_endian_bytes(checkpoint.hist_dt_global))
+    parts.append(little_endian_bytes(checkpoint.last_hit_us))
+    if checkpoint.latest_intervals:
+        latest_t_start_us, latest_t_end_us, latest_by_channel, latest_global = checkpoint.latest_intervals
+        parts.append(LATEST_INTERVALS_HEADER.pack(1, latest_t_start_us, latest_t_end_us))
+        parts.append(little_endian_bytes(latest_by_channel))
+        parts.append(little_endian_bytes(latest_global))
+    else:
+        parts.append(LATEST_INTERVALS_HEADER.pack(0, 0, 0))
+    parts.append(
+        RATE_RING_HEADER.pack(
+            checkpoint.rate_bin_us, checkpoint.rate_bins, checkpoint.rate_channels, checkpoint.rate_last_bin
+        )
+    )
+    parts.append(little_endian_bytes(checkpoint.rate_counts))
+    for blob in (
+        json.dumps(variable, separators=(",", ":")).encode("utf-8"),
+        checkpoint.latest_snapshot or b"",
+        checkpoint.latest_snapshot_binary or b"",
+    ):
+        parts.append(BLOB_LENGTH.pack(len(blob)))
+        parts.append(blob)
+    return b"".join(parts)
+
+
+def decode_checkpoint(data: bytes) -> Checkpoint:
+    if len(data) < CHECKPOINT_HEADER.size:
+        raise CheckpointFormatError("truncated checkpoint")
+    (
+        magic,
+        version,
+        channels,
+        max_channels,
+        running,
+        window_s,
+        sample_s,
+        saved_at_us,
+        t_start_us,
+        t_end_us,
+        sample_t_start_us,
+        sample_t_end_us,
+        t_offset_us,
+    ) = CHECKPOINT_HEADER.unpack_from(data, 0)
+    if magic != CHECKPOINT_MAGIC or version != CHECKPOINT_VERSION:
+        raise CheckpointFormatError("not a quicklook checkpoint")
+    offset = CHECKPOINT_HEADER.size
+
+    def take_values(typecode: str, count: int) -> array:
+        nonlocal offset
+        end = offset + array(typecode).itemsize * count
+        if end > len(data):
+            raise CheckpointFormatError("truncated checkpoint")
+        values = array(typecode, data[offset:end])
+        if sys.byteorder == "big":
+            values.byteswap()
+        offset = end
+        return values
+
+    def take_header(header: struct.Struct) -> tuple:
+        nonlocal offset
+        if offset + header.size > len(data):
+            raise CheckpointFormatError("truncated checkpoint")
+        values = header.unpack_from(data, offset)
+        offset += header.size
+        return values
+
+    def take_blob() -> bytes:
+        nonlocal offset
+        if offset + BLOB_LENGTH.size > len(data):
+            raise CheckpointFormatError("truncated checkpoint")
+        (length,) = BLOB_LENGTH.unpack_from(data, offset)
+        offset += BLOB_LENGTH.size
+        if offset + length > len(data):
+            raise CheckpointFormatError("truncated checkpoint")
+        blob = data[offset : offset + length]
+        offset += length
+        return blob
+
+    counts = take_values("I", max_channels)
+    sample_counts = take_values("I", max_channels)
+    hists = {name: take_values("I", max_channels * HIST_BINS) for name in HIST_NAMES}
+    adc_sums = {name: take_values("Q", max_channels) for name in HIST_NAMES}
+    run_t_start_us, run_t_end_us = take_header(RUN_HEADER)
+    run_counts = take_values("Q", max_channels)
+    run_hists = {name: take_values("Q", max_channels * HIST_BINS) for name in HIST_NAMES}
+    dt_bins, last_any_hit_us = take_header(INTERVAL_HEADER)
+    hist_dt = take_values("I", max_channels * dt_bins)
+    hist_dt_global = take_values("I", dt_bins)
+    last_hit_us = take_values("q", max_channels)
+    has_latest, latest_t_start_us, latest_t_end_us = take_header(LATEST_INTERVALS_HEADER)
+    latest_intervals = None
+    if has_latest:
+        latest_by_channel = take_values("I", max_channels * dt_bins)
+        latest_intervals = (latest_t_start_us, latest_t_end_us, latest_by_channel, take_values("I", dt_bins))
+    rate_bin_us, rate_bins, rate_channels, rate_last_bin = take_header(RATE_RING_HEADER)
+    rate_counts = take_values("I", rate_channels * rate_bins)
+    try:
+        variable = json.loads(take_blob())
+    except ValueError as exc:
+        raise CheckpointFormatError("bad checkpoint state") from exc
+    latest_snapshot = take_blob() or None
+    latest_snapshot_binary = take_blob() or None
+    return Checkpoint(
+        channels=channels,
+        running=bool(running),
+        window_s=window_s,
+        sample_s=sample_s,
+        saved_at_us=saved_at_us,
+        t_start_us=t_start_us,
+        t_end_us=t_end_us,
+        sample_t_start_us=sample_t_start_us,
+        sample_t_end_us=sample_t_end_us,
+        t_offset_us=t_offset_us,
+        counts_by_channel=counts,
+        sample_counts_by_channel=sample_counts,
+        hists=hists,
+        adc_sums=adc_sums,
+        rate_history=variable["rate_history"],
+        rate_history_t_end_us=variable["rate_history_t_end_us"],
+        quality=variable["quality"],
+        notes=variable["notes"],
+        run_t_start_us=run_t_start_us,
+        run_t_end_us=run_t_end_us,
+        run_counts_by_channel=run_counts,
+        run_hists=run_hists,
+        dt_bins=dt_bins,
+        hist_dt=hist_dt,
+        hist_dt_global=hist_dt_global,
+        last_hit_us=last_hit_us,
+        last_any_hit_us=last_any_hit_us,
+        latest_intervals=latest_intervals,
+        rate_bin_us=rate_bin_us,
+        rate_bins=rate_bins,
+        rate_channels=rate_channels,
+        rate_last_bin=rate_last_bin,
+        rate_counts=rate_counts,
+        session=variable.get("session") or {},
+        latest_snapshot=latest_snapshot,
+        latest_snapshot_binary=latest_snapshot_binary,
+    )
+
+
+def write_checkpoint(path: str, checkpoint: Checkpoint) -> int:
+    """Writes the checkpoint via a temporary file and atomic rename; returns its size."""
+    data = encode_checkpoint(checkpoint)
+    tmp_path = f"{path}.tmp"
+    with open(tmp_path, "wb") as tmp_fp:
+        tmp_fp.write(data)
+        tmp_fp.flush()
+        os.fsync(tmp_fp.fileno())
+    os.replace(tmp_path, path)
+    return len(data)
+
+
+def read_checkpoint(path: str) -> Optional[Checkpoint]:
+    try:
+        with open(path, "rb") as checkpoint_fp:
+            data = checkpoint_fp.read()
+    except FileNotFoundError:
+        return None
+    return decode_checkpoint(data)
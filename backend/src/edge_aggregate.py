@@ -0,0 +1,109 @@
+"""Partial aggregates shipped by the hardware adapter's edge pre-aggregation mode.
+
+A frame carries per-channel counts, ADC sums and 64-bin histograms for one short slice of event
+time (docs/02-Data-Contract.md, section C). Frames share the live stream with NDJSON lines and are
+told apart by their first byte, 0x1E, which never starts a JSON line.
+"""
+
+from __future__ import annotations
+
+import base64
+import struct
+import sys
+from array import array
+from dataclasses import dataclass, field
+from typing import BinaryIO, List, Optional, Tuple
+
+AGGREGATE_MARKER = 0x1E
+AGGREGATE_MAGIC = b"QLA"
+AGGREGATE_VERSION = 2
+# marker, magic, version, bins, t_start_us, t_end_us, events, channel entries
+AGGREGATE_HEADER = struct.Struct("<B3sBBqqIH")
+# channel, count, adc_x sum, adc_gtop sum, adc_gbot sum; followed by u32 adc_x[bins], adc_gtop[bins], adc_gbot[bins]
+AGGREGATE_CHANNEL = struct.Struct("<BIQQQ")
+# Version 1 entries (older adapters and recordings) have no sums: channel, count.
+AGGREGATE_CHANNEL_V1 = struct.Struct("<BI")
+ENTRY_HEADERS = {1: AGGREGATE_CHANNEL_V1, AGGREGATE_VERSION: AGGREGATE_CHANNEL}
+
+
+class AggregateFormatError(ValueError):
+    pass
+
+
+@dataclass
+class ChannelAggregate:
+    channel: int
+    count: int
+    hist_adc_x: array
+    hist_adc_gtop: array
+    hist_adc_gbot: array
+    # Exact adc_x, adc_gtop, adc_gbot sums; estimated from bin centres for version 1 frames.
+    adc_sums: Tuple[int, int, int]
+
+
+@dataclass
+class PartialAggregate:
+    t_start_us: int
+    t_end_us: int
+    events: int
+    bins: int
+    channels: List[ChannelAggregate] = field(default_factory=list)
+
+
+def frame_length(header: bytes) -> Tuple[int, int]:
+    """Returns (total frame length, bins) from a frame header."""
+    marker, magic, version, bins, _, _, _, entries = AGGREGATE_HEADER.unpack(header)
+    if marker != AGGREGATE_MARKER or magic != AGGREGATE_MAGIC or version not in ENTRY_HEADERS or bins == 0:
+        raise AggregateFormatError("bad aggregate frame header")
+    return AGGREGATE_HEADER.size + entries * (ENTRY_HEADERS[version].size + 3 * 4 * bins), bins
+
+
+def bin_center_sum(hist: array) -> int:
+    """ADC sum estimated from a 64-count-wide-bin histogram (see adc_to_bin)."""
+    return sum(count * (bin_index * 64 + 32) for bin_index, count in enumerate(hist) if count)
+
+
+def read_frame(reader: BinaryIO) -> Optional[bytes]:
+    """Reads one whole frame from a buffered binary stream positioned at its marker; None at EOF."""
+    header = reader.read(AGGREGATE_HEADER.size)
+    if len(header) < AGGREGATE_HEADER.size:
+        return None
+    length, _ = frame_length(header)
+    body = reader.read(length - len(header))
+    if len(body) < length - len(header):
+        return None
+    return header + body
+
+
+def decode_frame(frame: bytes) -> PartialAggregate:
+    length, bins = frame_length(frame[: AGGREGATE_HEADER.size])
+    if len(frame) != length:
+        raise AggregateFormatError("truncated aggregate frame")
+    _, _, version, _, t_start_us, t_end_us, events, entries = AGGREGATE_HEADER.unpack_from(frame, 0)
+    partial = PartialAggregate(t_start_us=t_start_us, t_end_us=t_end_us, events=events, bins=bins)
+    entry_header = ENTRY_HEADERS[version]
+    offset = AGGREGATE_HEADER.size
+    hist_bytes = 4 * bins
+    for _ in range(entries):
+        channel, count, *adc_sums = entry_header.unpack_from(frame, offset)
+        offset += entry_header.size
+        hists = []
+        for _ in range(3):
+            hist = array("I", frame[offset : offset + hist_bytes])
+            if sys.byteorder == "big":
+                hist.byteswap()
+            hists.append(hist)
+            offset += hist_bytes
+        if not adc_sums:
+            adc_sums = [bin_center_sum(hist) for hist in hists]
+        partial.channels.append(ChannelAggregate(channel, count, *hists, adc_sums=tuple(adc_sums)))
+    return partial
+
+
+def frame_record_line(frame: bytes) -> str:
+    """NDJSON form used when recording, so record files stay line-oriented."""
+    return '{"aggregate":"' + base64.b64encode(frame).decode("ascii") + '"}\n'
+
+
+def frame_from_record(value: str) -> bytes:
+    return base64.b64decode(value, validate=True)
@@ -1,30 +1,155 @@
 from __future__ import annotations
 
+import heapq
 import json
+import mmap
 import os
+import re
 import socket
 import threading
 import time
+from array import array
 from collections import deque
+from contextlib import ExitStack
 from dataclasses import dataclass, field
-from typing import Dict, List, Optional
+from operator import itemgetter
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Tuple
 
-from fastapi import FastAPI, HTTPException
+from fastapi import APIRouter, Depends, FastAPI, HTTPException, Response
+from fastapi.responses import StreamingResponse
 from fastapi.middleware.cors import CORSMiddleware
-from pydantic import BaseModel
+from pydantic import BaseModel, Field
+
+from .checkpoint import Checkpoint, CheckpointFormatError, read_checkpoint, write_checkpoint
+from .edge_aggregate import (
+    AGGREGATE_MARKER,
+    AggregateFormatError,
+    PartialAggregate,
+    decode_frame,
+    frame_from_record,
+    frame_record_line,
+    read_frame,
+)
+from .snapshot_serializer import (
+    HIST_BINS,
+    HIST_NAMES,
+    RATE_HISTORY_LEN,
+    PublishedSnapshot,
+    SNAPSHOT_FIELDS,
+    SnapshotSerializer,
+    int_list_text,
+    parse_channels,
+    parse_fields,
+    published_from_json,
+)
+from .rate_ring import RateRing, encode_rates
+from .snapshot_stream import SnapshotHub, filter_key
+from .spatial import empty_spatial_text, load_geometry, spatial_text
+from .stream_compression import COMPRESSION_DEFLATE, COMPRESSION_NONE, TransportStats, open_source_stream
+
+MODE_LIVE = "live"
+MODE_RECORD = "record"
+MODE_REPLAY = "replay"
+MAX_CHANNELS = max(1, int(os.getenv("QUICKLOOK_MAX_CHANNELS", "64")))
+MIN_CHANNELS = 1
+# `ratemap_8x8` covers channels 0..63 only; higher channels appear in `spatial` via QUICKLOOK_GEOMETRY.
+RATEMAP_CHANNELS = 64
+MIN_WINDOW_S = 1
+MAX_WINDOW_S = 3600
+RECONNECT_INITIAL_S = 0.01
+RECONNECT_MAX_S = float(os.getenv("QUICKLOOK_RECONNECT_MAX_S", "0.25"))
+CHECKPOINT_PATH = os.getenv("QUICKLOOK_CHECKPOINT_PATH")
+CHECKPOINT_INTERVAL_S = float(os.getenv("QUICKLOOK_CHECKPOINT_S", "5"))
+# Rate ring values copied per lock hold while checkpointing (256 KiB).
+RATE_RING_COPY_CHUNK = 65536
+RATE_BIN_MS = float(os.getenv("QUICKLOOK_RATE_BIN_MS", "10"))
+RATE_RING_S = float(os.getenv("QUICKLOOK_RATE_RING_S", "300"))
+DEFAULT_SESSION = "default"
+SESSION_ID_PATTERN = r"^[A-Za-z0-9_-]{1,64}$"
+INGEST_THREADS = max(1, int(os.getenv("QUICKLOOK_INGEST_THREADS", "4")))
+GEOMETRY = load_geometry(os.getenv("QUICKLOOK_GEOMETRY", "8x8"), MAX_CHANNELS)
+COMPRESSION = os.getenv("QUICKLOOK_COMPRESSION", COMPRESSION_NONE)
+ALIGN_WINDOWS = os.getenv("QUICKLOOK_ALIGN_WINDOWS", "0") == "1"
+# Aligned mode: how long past a sample boundary (in estimated event time) the timer waits for
+# late events before publishing the sample itself, and how often it checks.
+PUBLISH_GRACE_S = float(os.getenv("QUICKLOOK_PUBLISH_GRACE_MS", "250")) / 1000.0
+PUBLISH_TIMER_S = 0.05
+
+ZERO_COUNTS = array("I", bytes(4 * MAX_CHANNELS))
+ZERO_HIST = array("I", bytes(4 * MAX_CHANNELS * HIST_BINS))
+ZERO_ADC_SUMS = array("Q", bytes(8 * MAX_CHANNELS))
+# Inter-arrival bins: bin 0 is dt == 0, bin k holds 2**(k-1) <= dt_us < 2**k, the last is open-ended.
+DT_BINS = 32
+ZERO_DT_HIST = array("I", bytes(4 * MAX_CHANNELS * DT_BINS))
+ZERO_DT_GLOBAL = array("I", bytes(4 * DT_BINS))
+
+
+def zero_counts() -> array:
+    return array("I", ZERO_COUNTS)
+
+
+def zero_hist() -> array:
+    return array("I", ZERO_HIST)
+
+
+def zero_adc_sums() -> array:
+    return array("Q", ZERO_ADC_SUMS)
+
+
+def zero_dt_hist() -> array:
+    return array("I", ZERO_DT_HIST)
+
+
+def zero_dt_global() -> array:
+    return array("I", ZERO_DT_GLOBAL)
+
+
+def zero_last_hits() -> array:
+    return array("q", bytes(8 * MAX_CHANNELS))
+
+
+def empty_rate_history() -> List[deque]:
+    return [deque(maxlen=RATE_HISTORY_LEN) for _ in range(MAX_CHANNELS)]
+
+
+def new_rate_ring(channels: int) -> RateRing:
+    """Sized by the session's channel count: RATE_RING_S / RATE_BIN_MS bins of 4 bytes per channel."""
+    bin_us = max(1, int(RATE_BIN_MS * 1000))
+    return RateRing(bin_us, max(1, int(RATE_RING_S * 1_000_000) // bin_us), channels)
+
+
+def empty_quality() -> Dict[str, int]:
+    return {
+        "invalid_json": 0,
+        "invalid_channel": 0,
+        "invalid_fields": 0,
+        "reconnects": 0,
+        "gap_ms": 0,
+        "lost_events_est": 0,
+    }
 
 
 @dataclass
 class AggregationWindow:
+    """Counters are flat uint32 arrays; histogram bin `b` of channel `c` is at `c * HIST_BINS + b`."""
+
     window_s: int
     sample_s: int
     t_start_us: int = 0
     t_end_us: int = 0
-    counts_by_channel: Dict[int, int] = field(default_factory=dict)
-    hist_adc_x: Dict[int, List[int]] = field(default_factory=dict)
-    hist_adc_gtop: Dict[int, List[int]] = field(default_factory=dict)
-    hist_adc_gbot: Dict[int, List[int]] = field(default_factory=dict)
-    sample_counts_by_channel: Dict[int, int] = field(default_factory=dict)
+    counts_by_channel: array = field(default_factory=zero_counts)
+    hist_adc_x: array = field(default_factory=zero_hist)
+    hist_adc_gtop: array = field(default_factory=zero_hist)
+    hist_adc_gbot: array = field(default_factory=zero_hist)
+    # Exact per-channel ADC sums; the spatial mean-ADC maps divide them by the counts at publish.
+    adc_sum_x: array = field(default_factory=zero_adc_sums)
+    adc_sum_gtop: array = field(default_factory=zero_adc_sums)
+    adc_sum_gbot: array = field(default_factory=zero_adc_sums)
+    # Log2 inter-arrival histograms: per channel at `channel * DT_BINS + bin`, and across channels.
+    hist_dt: array = field(default_factory=zero_dt_hist)
+    hist_dt_global: array = field(default_factory=zero_dt_global)
+    sample_counts_by_channel: array = field(default_factory=zero_counts)
     notes: List[str] = field(default_factory=list)
     sample_t_start_us: int = 0
     sample_t_end_us: int = 0
@@ -32,15 +157,73 @@ class AggregationWindow:
     def reset(self) -> None:
         self.t_start_us = 0
         self.t_end_us = 0
-        self.counts_by_channel.clear()
-        self.hist_adc_x.clear()
-        self.hist_adc_gtop.clear()
-        self.hist_adc_gbot.clear()
-        self.sample_counts_by_channel.clear()
+        self.counts_by_channel[:] = ZERO_COUNTS
+        self.hist_adc_x[:] = ZERO_HIST
+        self.hist_adc_gtop[:] = ZERO_HIST
+        self.hist_adc_gbot[:] = ZERO_HIST
+        self.adc_sum_x[:] = ZERO_ADC_SUMS
+        self.adc_sum_gtop[:] = ZERO_ADC_SUMS
+        self.adc_sum_gbot[:] = ZERO_ADC_SUMS
+        self.hist_dt[:] = ZERO_DT_HIST
+        self.hist_dt_global[:] = ZERO_DT_GLOBAL
+        self.sample_counts_by_channel[:] = ZERO_COUNTS
         self.notes.clear()
         self.sample_t_start_us = 0
         self.sample_t_end_us = 0
 
+    def histograms(self) -> Dict[str, array]:
+        return {"adc_x": self.hist_adc_x, "adc_gtop": self.hist_adc_gtop, "adc_gbot": self.hist_adc_gbot}
+
+    def adc_sums(self) -> Dict[str, array]:
+        return {"adc_x": self.adc_sum_x, "adc_gtop": self.adc_sum_gtop, "adc_gbot": self.adc_sum_gbot}
+
+
+def zero_u64(size: int) -> array:
+    return array("Q", bytes(8 * size))
+
+
+@dataclass
+class RunAccumulators:
+    """64-bit counts and histograms of the run's completed windows, same layout as the window's.
+
+    A window is folded in once, when it is reset, so neither ingest nor publishing pays for the
+    run; readers add the live window on top (see run_snapshot).
+    """
+
+    t_start_us: int = 0
+    t_end_us: int = 0
+    counts_by_channel: array = field(default_factory=lambda: zero_u64(MAX_CHANNELS))
+    hists: Dict[str, array] = field(
+        default_factory=lambda: {name: zero_u64(MAX_CHANNELS * HIST_BINS) for name in HIST_NAMES}
+    )
+
+    def reset(self) -> None:
+        self.t_start_us = 0
+        self.t_end_us = 0
+        self.counts_by_channel[:] = zero_u64(MAX_CHANNELS)
+        for hist in self.hists.values():
+            hist[:] = zero_u64(MAX_CHANNELS * HIST_BINS)
+
+    def fold(self, window: AggregationWindow) -> None:
+        """Adds a finished window to the totals."""
+        if window.t_start_us == 0:
+            return
+        if self.t_start_us == 0:
+            self.t_start_us = window.t_start_us
+        self.t_end_us = max(self.t_end_us, window.t_end_us)
+        pairs = [(self.counts_by_channel, window.counts_by_channel)]
+        window_hists = window.histograms()
+        pairs += [(self.hists[name], window_hists[name]) for name in HIST_NAMES]
+        for total, current in pairs:
+            total[:] = array("Q", map(int.__add__, total, current))
+
+
+@dataclass
+class SourceGap:
+    started: float
+    last_t_us: int
+    rate_hz: float
+
 
 @dataclass
 class AcquisitionState:
@@ -57,38 +240,65 @@ class AcquisitionState:
     paused: bool = False
     connected: bool = False
     last_error: Optional[str] = None
-    latest_snapshot: Optional[dict] = None
+    latest_snapshot: Optional[bytes] = None
+    latest_parts: Optional[PublishedSnapshot] = None
+    hub: SnapshotHub = field(default_factory=SnapshotHub)
+    rates: RateRing = field(init=False)
+    # Previous hit per channel and on any channel, for inter-arrival times; 0 = none yet.
+    last_hit_us: array = field(default_factory=zero_last_hits)
+    last_any_hit_us: int = 0
+    # Inter-arrival histograms as of the latest publish: (t_start_us, t_end_us, per channel, global).
+    latest_intervals: Optional[Tuple[int, int, array, array]] = None
+    run: RunAccumulators = field(default_factory=RunAccumulators)
+    latest_snapshot_binary: Optional[bytes] = None
     thread: Optional[threading.Thread] = None
+    # Live source connection, so /stop can wake a reader blocked on a quiet stream.
+    source_socket: Optional[socket.socket] = None
     stop_event: threading.Event = field(default_factory=threading.Event)
     lock: threading.Lock = field(default_factory=threading.Lock)
     window: AggregationWindow = field(init=False)
-    rate_history: Dict[int, deque] = field(default_factory=dict)
-    rate_history_t_end_us: deque = field(default_factory=deque)
-    quality: Dict[str, int] = field(
-        default_factory=lambda: {
-            "invalid_json": 0,
-            "invalid_channel": 0,
-            "invalid_fields": 0,
-        }
-    )
+    serializer: SnapshotSerializer = field(init=False)
+    rate_history: List[deque] = field(default_factory=empty_rate_history)
+    rate_history_t_end_us: deque = field(default_factory=lambda: deque(maxlen=RATE_HISTORY_LEN))
+    quality: Dict[str, int] = field(default_factory=empty_quality)
+    # Live mode: set while the source is gone, resolved by the first record after reconnecting.
+    gap: Optional[SourceGap] = None
+    # Added to incoming timestamps so a restarted source continues the window's timeline.
+    t_offset_us: int = 0
+    # Set when state was loaded from a checkpoint; the next start continues it instead of resetting.
+    restored: bool = False
+    # Samples and windows on multiples of sample_s / window_s in event time (see advance_aligned).
+    aligned: bool = ALIGN_WINDOWS
+    # Transport compression to request from live sources, and what the connections actually used.
+    compression: str = COMPRESSION
+    transport: TransportStats = field(default_factory=TransportStats)
 
     def __post_init__(self) -> None:
         self.window = AggregationWindow(window_s=self.window_s, sample_s=self.sample_s)
+        self.serializer = SnapshotSerializer(self.channels)
+        self.rates = new_rate_ring(self.channels)
+
+
+class SessionCreateRequest(BaseModel):
+    session_id: str = Field(pattern=SESSION_ID_PATTERN)
+    mode: str = MODE_LIVE
+    sim_host: str = "127.0.0.1"
+    sim_port: int = 9001
+    record_path: Optional[str] = None
+    replay_path: Optional[str] = None
+    replay_speed: float = 1.0
+    window_s: int = 10
+    sample_s: Optional[int] = None
+    channels: int = 64
+    aligned: bool = ALIGN_WINDOWS
+    compression: str = COMPRESSION
 
 
 class ConfigUpdateRequest(BaseModel):
     window_s: Optional[int] = None
     sample_s: Optional[int] = None
     channels: Optional[int] = None
-
-
-MODE_LIVE = "live"
-MODE_RECORD = "record"
-MODE_REPLAY = "replay"
-MAX_CHANNELS = 64
-MIN_CHANNELS = 1
-MIN_WINDOW_S = 1
-MAX_WINDOW_S = 3600
+    aligned: Optional[bool] = None
 
 
 def adc_to_bin(adc: int) -> int:
@@ -101,103 +311,79 @@ def default_sample_s(window_s: int) -> int:
     return max(1, round(window_s / 5))
 
 
-def empty_snapshot(window_s: int, sample_s: int, channels: int) -> dict:
-    channel_ids = list(range(channels))
-    return {
-        "window_s": window_s,
-        "sample_s": sample_s,
-        "t_start_us": 0,
-        "t_end_us": 0,
-        "channels": channel_ids,
-        "counts_by_channel": {str(channel): 0 for channel in channel_ids},
-        "histograms": {
-            "adc_x": {str(channel): [0 for _ in range(64)] for channel in channel_ids},
-            "adc_gtop": {str(channel): [0 for _ in range(64)] for channel in channel_ids},
-            "adc_gbot": {str(channel): [0 for _ in range(64)] for channel in channel_ids},
-        },
-        "ratemap_8x8": [[0.0 for _ in range(8)] for _ in range(8)],
-        "rate_history": {str(channel): [] for channel in channel_ids},
-        "rate_history_t_end_us": [],
-        "quality": {
-            "invalid_json": 0,
-            "invalid_channel": 0,
-            "invalid_fields": 0,
-        },
-        "notes": ["no data yet"],
-    }
-
+def empty_snapshot(window_s: int, sample_s: int, channels: int) -> bytes:
+    return empty_snapshot_parts(window_s, sample_s, channels).full()
 
-def build_snapshot(
-    window: AggregationWindow,
-    channels: int,
-    rate_history: Dict[int, deque],
-    rate_history_t_end_us: deque,
-    quality: Dict[str, int],
-) -> dict:
-    channel_ids = list(range(channels))
-    counts_by_channel = {
-        str(channel): window.counts_by_channel.get(channel, 0) for channel in channel_ids
-    }
 
-    ratemap = [[0.0 for _ in range(8)] for _ in range(8)]
-    sample_duration_s = max(window.sample_s, 1)
-    for ch, count in window.sample_counts_by_channel.items():
-        channel = int(ch)
-        rate = count / float(sample_duration_s)
-        rate_history.setdefault(channel, deque(maxlen=30)).append(rate)
-
-    for ch in counts_by_channel:
-        channel = int(ch)
-        rate_history.setdefault(channel, deque(maxlen=30))
+def empty_snapshot_parts(window_s: int, sample_s: int, channels: int) -> PublishedSnapshot:
+    window = AggregationWindow(window_s=window_s, sample_s=sample_s)
+    return SnapshotSerializer(channels).serialize_parts(
+        window_s,
+        sample_s,
+        0,
+        0,
+        window.counts_by_channel,
+        window.histograms(),
+        [[0.0 for _ in range(8)] for _ in range(8)],
+        empty_quality(),
+        ["no data yet"],
+        empty_spatial_text(GEOMETRY),
+    )
 
-    if window.sample_t_end_us > 0:
-        rate_history_t_end_us.append(window.sample_t_end_us)
-        while len(rate_history_t_end_us) > 30:
-            rate_history_t_end_us.popleft()
-
-    for ch, count in window.sample_counts_by_channel.items():
-        row = ch // 8
-        col = ch % 8
-        if row < 8 and col < 8:
-            ratemap[row][col] = count / float(sample_duration_s)
-
-    histograms = {
-        "adc_x": {
-            str(channel): window.hist_adc_x.get(channel, [0 for _ in range(64)])
-            for channel in channel_ids
-        },
-        "adc_gtop": {
-            str(channel): window.hist_adc_gtop.get(channel, [0 for _ in range(64)])
-            for channel in channel_ids
-        },
-        "adc_gbot": {
-            str(channel): window.hist_adc_gbot.get(channel, [0 for _ in range(64)])
-            for channel in channel_ids
-        },
-    }
 
-    return {
-        "window_s": window.window_s,
-        "sample_s": window.sample_s,
-        "t_start_us": window.t_start_us,
-        "t_end_us": window.t_end_us,
-        "channels": channel_ids,
-        "counts_by_channel": counts_by_channel,
-        "histograms": histograms,
-        "ratemap_8x8": ratemap,
-        "rate_history": {
-            str(channel): list(rate_history.get(channel, deque())) for channel in channel_ids
-        },
-        "rate_history_t_end_us": list(rate_history_t_end_us),
-        "quality": dict(quality),
-        "notes": window.notes,
-    }
+def publish_snapshot(state: AcquisitionState) -> None:
+    """Folds the finished sample into the rate history and serializes the window. Caller holds state.lock."""
+    window = state.window
+    sample_duration_s = float(max(window.sample_s, 1))
 
+    serializer = state.serializer
+    ratemap = [[0.0 for _ in range(8)] for _ in range(8)]
+    for channel, count in enumerate(window.sample_counts_by_channel):
+        if count:
+            rate = count / sample_duration_s
+            state.rate_history[channel].append(rate)
+            serializer.append_rate(channel, rate)
+            if channel < RATEMAP_CHANNELS:
+                ratemap[channel // 8][channel % 8] = rate
+        elif state.aligned and channel < state.channels:
+            # Every sample is a point for every channel, so the series line up with t_end_us.
+            state.rate_history[channel].append(0.0)
+            serializer.append_rate(channel, 0.0)
 
-def ensure_hist(hist_map: Dict[int, List[int]], channel: int) -> List[int]:
-    if channel not in hist_map:
-        hist_map[channel] = [0 for _ in range(64)]
-    return hist_map[channel]
+    if window.sample_t_end_us > 0:
+        state.rate_history_t_end_us.append(window.sample_t_end_us)
+        serializer.append_rate_t_end(window.sample_t_end_us)
+
+    hists = window.histograms()
+    state.latest_parts = serializer.serialize_parts(
+        window.window_s,
+        window.sample_s,
+        window.t_start_us,
+        window.t_end_us,
+        window.counts_by_channel,
+        hists,
+        ratemap,
+        state.quality,
+        window.notes,
+        spatial_text(GEOMETRY, state.channels, window.counts_by_channel, window.adc_sums()),
+    )
+    state.latest_snapshot = state.latest_parts.full()
+    state.hub.publish(state.latest_parts)
+    state.latest_intervals = (
+        window.t_start_us,
+        window.t_end_us,
+        array("I", window.hist_dt),
+        array("I", window.hist_dt_global),
+    )
+    state.latest_snapshot_binary = serializer.serialize_binary(
+        window.window_s,
+        window.sample_s,
+        window.t_start_us,
+        window.t_end_us,
+        window.counts_by_channel,
+        hists,
+        ratemap,
+    )
 
 
 def process_event(state: AcquisitionState, event: dict) -> None:
@@ -223,43 +409,284 @@ def process_event(state: AcquisitionState, event: dict) -> None:
             state.quality["invalid_channel"] += 1
             state.quality["invalid_channel"] += 1
             return
+        if state.gap is not None:
+            resolve_gap(state, t_us)
+        t_us += state.t_offset_us
+
+        window = state.window
+        if state.aligned:
+            advance_aligned(state, t_us)
+        elif window.t_start_us == 0:
+            window.t_start_us = t_us
+            window.sample_t_start_us = t_us
+        window.t_end_us = t_us
+        window.sample_t_end_us = t_us
+        window.counts_by_channel[channel] += 1
+        window.sample_counts_by_channel[channel] += 1
+        rates = state.rates
+        if t_us // rates.bin_us == rates.last_bin:
+            rates.counts[rates.last_slot + channel] += 1
+        else:
+            slot = rates.slot_index(t_us)
+            if slot >= 0:
+                rates.counts[slot + channel] += 1
+
+        base = channel * HIST_BINS
+        window.hist_adc_x[base + adc_to_bin(adc_x)] += 1
+        window.hist_adc_gtop[base + adc_to_bin(adc_gtop)] += 1
+        window.hist_adc_gbot[base + adc_to_bin(adc_gbot)] += 1
+        window.adc_sum_x[channel] += adc_x
+        window.adc_sum_gtop[channel] += adc_gtop
+        window.adc_sum_gbot[channel] += adc_gbot
+
+        last_hit_us = state.last_hit_us[channel]
+        if 0 < last_hit_us <= t_us:
+            window.hist_dt[channel * DT_BINS + min((t_us - last_hit_us).bit_length(), DT_BINS - 1)] += 1
+        state.last_hit_us[channel] = t_us
+        if 0 < state.last_any_hit_us <= t_us:
+            window.hist_dt_global[min((t_us - state.last_any_hit_us).bit_length(), DT_BINS - 1)] += 1
+        state.last_any_hit_us = t_us
+
+        if not state.aligned:
+            advance_window(state)
+
+
+def advance_window(state: AcquisitionState) -> None:
+    """Publishes at sample boundaries and resets at window boundaries. Caller holds state.lock."""
+    window = state.window
+    if window.sample_t_end_us - window.sample_t_start_us >= window.sample_s * 1_000_000:
+        publish_snapshot(state)
+
+        window.sample_counts_by_channel[:] = ZERO_COUNTS
+        window.sample_t_start_us = window.sample_t_end_us
+
+    if window.t_end_us - window.t_start_us >= window.window_s * 1_000_000:
+        reset_window(state)
+
+
+def advance_aligned(state: AcquisitionState, t_us: int) -> None:
+    """Closes every sample ending at or before t_us, then makes sure t_us has an open sample.
+
+    Samples cover [k * sample_s, (k + 1) * sample_s) of event time and each one is published
+    exactly once, with empty ones zero-filled. A window ends at the first sample boundary at or
+    after a multiple of window_s and the next one starts on that boundary. Caller holds state.lock.
+    """
+    window = state.window
+    sample_us = window.sample_s * 1_000_000
+    window_us = window.window_s * 1_000_000
+    if window.t_start_us == 0:
+        # t_start_us == 0 means "no data yet", so a window starting at event time 0 reports 1.
+        window.t_start_us = max(1, t_us - t_us % window_us)
+        window.sample_t_start_us = t_us - t_us % sample_us
+        window.sample_t_end_us = window.sample_t_start_us
+        return
+    published = 0
+    while t_us >= window.sample_t_start_us + sample_us:
+        boundary = window.sample_t_start_us + sample_us
+        if published >= RATE_HISTORY_LEN:
+            # A gap longer than the rate history: the skipped samples would all scroll out.
+            boundary = t_us - t_us % sample_us
+            window.sample_counts_by_channel[:] = ZERO_COUNTS
+        window.sample_t_end_us = boundary
+        window.t_end_us = max(window.t_end_us, boundary)
+        publish_snapshot(state)
+        published += 1
+        window.sample_counts_by_channel[:] = ZERO_COUNTS
+        window.sample_t_start_us = boundary
+        if boundary // window_us != (boundary - sample_us) // window_us:
+            reset_window(state)
+            window.t_start_us = boundary
+            window.t_end_us = boundary
+            window.sample_t_start_us = boundary
+            window.sample_t_end_us = boundary
+
+
+def run_publish_timer(state: AcquisitionState, speed: float) -> None:
+    """Aligned mode: publishes samples on schedule while no events arrive.
+
+    Event time is extrapolated from the newest event at `speed` event seconds per wall second, and a
+    sample is closed once that estimate passes its end by PUBLISH_GRACE_S, so a quiet source still
+    yields one (zero-filled) snapshot per sample_s.
+    """
+    # The newest event time and when it was first seen; `published_t_end_us` is the window end
+    # the timer itself left behind, so only a change made by an event moves the anchor.
+    anchor_us, anchor_at = 0, time.monotonic()
+    published_t_end_us = -1
+    while not state.stop_event.wait(PUBLISH_TIMER_S):
+        with state.lock:
+            window = state.window
+            now = time.monotonic()
+            if state.paused or window.t_start_us == 0 or window.t_end_us != published_t_end_us:
+                anchor_us, anchor_at = window.t_end_us, now
+                published_t_end_us = window.t_end_us
+                continue
+            estimate_us = anchor_us + int((now - anchor_at - PUBLISH_GRACE_S) * speed * 1_000_000)
+            if estimate_us >= window.sample_t_start_us + window.sample_s * 1_000_000:
+                advance_aligned(state, estimate_us)
+                published_t_end_us = window.t_end_us
+
 
-        if state.window.t_start_us == 0:
-            state.window.t_start_us = t_us
-            state.window.sample_t_start_us = t_us
-        state.window.t_end_us = t_us
-        state.window.sample_t_end_us = t_us
-        state.window.counts_by_channel[channel] = state.window.counts_by_channel.get(channel, 0) + 1
-        state.window.sample_counts_by_channel[channel] = state.window.sample_counts_by_channel.get(channel, 0) + 1
+def reset_window(state: AcquisitionState) -> None:
+    """Starts a new window, first folding the finished one into the run. Caller holds state.lock."""
+    state.run.fold(state.window)
+    state.window.reset()
 
-        ensure_hist(state.window.hist_adc_x, channel)[adc_to_bin(adc_x)] += 1
-        ensure_hist(state.window.hist_adc_gtop, channel)[adc_to_bin(adc_gtop)] += 1
-        ensure_hist(state.window.hist_adc_gbot, channel)[adc_to_bin(adc_gbot)] += 1
 
-        if state.window.sample_t_end_us - state.window.sample_t_start_us >= state.window.sample_s * 1_000_000:
-            state.latest_snapshot = build_snapshot(
-                state.window,
-                state.channels,
-                state.rate_history,
-                state.rate_history_t_end_us,
-                state.quality,
-            )
+def add_hist(target: array, base: int, values: array) -> None:
+    target[base : base + HIST_BINS] = array("I", map(int.__add__, target[base : base + HIST_BINS], values))
 
-            state.window.sample_counts_by_channel.clear()
-            state.window.sample_t_start_us = state.window.sample_t_end_us
 
-        if state.window.t_end_us - state.window.t_start_us >= state.window.window_s * 1_000_000:
-            state.window.reset()
+def merge_aggregate(state: AcquisitionState, partial: PartialAggregate) -> None:
+    """Folds an adapter partial aggregate into the window as if its events had arrived one by one."""
+    with state.lock:
+        if state.paused:
+            return
+        if partial.t_start_us <= 0 or partial.t_end_us < partial.t_start_us or partial.bins != HIST_BINS:
+            state.quality["invalid_fields"] += 1
+            return
+
+        if state.gap is not None:
+            resolve_gap(state, partial.t_start_us)
+        t_start_us = partial.t_start_us + state.t_offset_us
+        t_end_us = partial.t_end_us + state.t_offset_us
+
+        window = state.window
+        if state.aligned:
+            advance_aligned(state, t_start_us)
+        elif window.t_start_us == 0:
+            window.t_start_us = t_start_us
+            window.sample_t_start_us = t_start_us
+        for entry in partial.channels:
+            if entry.channel >= state.channels:
+                state.quality["invalid_channel"] += entry.count
+                continue
+            window.counts_by_channel[entry.channel] += entry.count
+            window.sample_counts_by_channel[entry.channel] += entry.count
+            state.rates.add_spread(t_start_us, t_end_us, entry.channel, entry.count)
+            base = entry.channel * HIST_BINS
+            add_hist(window.hist_adc_x, base, entry.hist_adc_x)
+            add_hist(window.hist_adc_gtop, base, entry.hist_adc_gtop)
+            add_hist(window.hist_adc_gbot, base, entry.hist_adc_gbot)
+            sum_x, sum_gtop, sum_gbot = entry.adc_sums
+            window.adc_sum_x[entry.channel] += sum_x
+            window.adc_sum_gtop[entry.channel] += sum_gtop
+            window.adc_sum_gbot[entry.channel] += sum_gbot
+        window.t_end_us = t_end_us
+        window.sample_t_end_us = t_end_us
+
+        if not state.aligned:
+            advance_window(state)
+
+
+def decode_recorded_aggregate(state: AcquisitionState, record: dict) -> Optional[PartialAggregate]:
+    try:
+        return decode_frame(frame_from_record(str(record["aggregate"])))
+    except (AggregateFormatError, ValueError):
+        with state.lock:
+            state.quality["invalid_fields"] += 1
+        return None
+
+
+def process_record(state: AcquisitionState, record: dict) -> None:
+    """Dispatches one decoded NDJSON record: an event or a recorded partial aggregate."""
+    if "aggregate" in record:
+        partial = decode_recorded_aggregate(state, record)
+        if partial:
+            merge_aggregate(state, partial)
+        return
+    if record.get("sampled"):
+        # Raw sample passed through next to partial aggregates; its event is already counted there.
+        return
+    process_event(state, record)
+
+
+def begin_gap(state: AcquisitionState) -> None:
+    """Notes where the stream stopped and the recent event rate. Caller holds state.lock."""
+    window = state.window
+    last_t_us = window.t_end_us or (state.rate_history_t_end_us[-1] if state.rate_history_t_end_us else 0)
+    span_s = (window.t_end_us - window.t_start_us) / 1_000_000.0
+    rate_hz = sum(window.counts_by_channel) / span_s if span_s > 0 else 0.0
+    state.gap = SourceGap(started=time.monotonic(), last_t_us=last_t_us, rate_hz=rate_hz)
+
+
+def resolve_gap(state: AcquisitionState, t_us: int) -> None:
+    """Accounts for a finished source gap on its first new record (raw t_us). Caller holds state.lock."""
+    gap = state.gap
+    state.gap = None
+    gap_s = max(0.0, time.monotonic() - gap.started)
+    gap_ms = int(gap_s * 1000)
+    lost = int(round(gap.rate_hz * gap_s))
+    state.quality["reconnects"] += 1
+    state.quality["gap_ms"] += gap_ms
+    state.quality["lost_events_est"] += lost
+    state.window.notes.append(f"source gap {gap_ms} ms, ~{lost} events lost")
+    # Intervals spanning the gap say nothing about the detector.
+    state.last_hit_us[:] = zero_last_hits()
+    state.last_any_hit_us = 0
+    if gap.last_t_us:
+        # A restarted source starts a new clock; continue the old one, advanced by the gap.
+        expected_us = gap.last_t_us + int(gap_s * 1_000_000)
+        t_us += state.t_offset_us
+        if t_us < gap.last_t_us or t_us - expected_us > state.window.window_s * 1_000_000:
+            state.t_offset_us += expected_us - t_us
+
+
+def run_live_with_reconnect(state: AcquisitionState, record_fp: Optional[object]) -> None:
+    """Runs `run_live` until stopped, reconnecting with exponential backoff and keeping the window."""
+    delay_s = RECONNECT_INITIAL_S
+    while not state.stop_event.is_set():
+        try:
+            run_live(state, record_fp)
+            reason = "source closed the stream"
+        except OSError as exc:
+            reason = str(exc) or type(exc).__name__
+        state.source_socket = None
+        if state.connected:
+            delay_s = RECONNECT_INITIAL_S
+        state.connected = False
+        if state.stop_event.is_set():
+            break
+        with state.lock:
+            state.last_error = f"reconnecting: {reason}"
+            if state.gap is None and (state.window.t_end_us or state.rate_history_t_end_us):
+                begin_gap(state)
+        if state.stop_event.wait(delay_s):
+            break
+        delay_s = min(delay_s * 2, RECONNECT_MAX_S)
 
 
 def run_live(state: AcquisitionState, record_fp: Optional[object]) -> None:
     with socket.create_connection((state.sim_host, state.sim_port), timeout=5) as sock:
+        # The timeout only bounds the connect. A quiet source is not a gap, so reads block until
+        # data, EOF or /stop shutting the socket down.
+        sock.settimeout(None)
+        state.source_socket = sock
+        if state.stop_event.is_set():
+            return
+        sock_file, state.transport.compression = open_source_stream(sock, state.compression, state.transport)
         state.connected = True
-        sock_file = sock.makefile("r")
-        for line in sock_file:
-            if state.stop_event.is_set():
+        state.last_error = None
+        while not state.stop_event.is_set():
+            head = sock_file.peek(1)[:1]
+            if not head:
                 break
-            line = line.strip()
+            if head[0] == AGGREGATE_MARKER:
+                try:
+                    frame = read_frame(sock_file)
+                except AggregateFormatError:
+                    # Unknown framing; resynchronize on the next line.
+                    with state.lock:
+                        state.quality["invalid_fields"] += 1
+                    sock_file.readline()
+                    continue
+                if frame is None:
+                    break
+                if record_fp:
+                    record_fp.write(frame_record_line(frame))
+                    record_fp.flush()
+                merge_aggregate(state, decode_frame(frame))
+                continue
+            line = sock_file.readline().decode("utf-8", errors="replace").strip()
             if not line:
                 continue
             if record_fp:
@@ -272,52 +699,156 @@ def run_live(state: AcquisitionState, record_fp: Optional[object]) -> None:
                     state.quality["invalid_json"] += 1
                     state.quality["invalid_json"] += 1
                 continue
-            process_event(state, event)
+            process_record(state, event)
+
+
+def iter_recorded_lines(state: AcquisitionState, replay_fp) -> Iterable[Tuple[int, dict, Optional[PartialAggregate]]]:
+    """Records from NDJSON lines (str or bytes) as (t_us, record, partial aggregate or None)."""
+    for line in replay_fp:
+        line = line.strip()
+        if not line:
+            continue
+        try:
+            event = json.loads(line)
+        except ValueError:
+            with state.lock:
+                state.quality["invalid_json"] += 1
+                state.quality["invalid_json"] += 1
+            continue
+        if "aggregate" in event:
+            partial = decode_recorded_aggregate(state, event)
+            if partial is not None:
+                yield partial.t_end_us, event, partial
+            continue
+        yield int(event.get("t_us", 0)), event, None
+
+
+def iter_capture_records(capture_dir: str) -> Iterable[Tuple[int, dict, Optional[PartialAggregate]]]:
+    """Decodes an adapter raw capture directory in place; no_data words are dropped like the adapter does.
+
+    Uses the adapter's own decoder so both sides agree on unwrap, mapping and session boundaries;
+    `hardware_adapter` is imported as a sibling package of `backend`, i.e. from the repository root.
+    """
+    from hardware_adapter.adapter import iter_capture_events
+
+    for event in iter_capture_events(Path(capture_dir)):
+        if event["flags"]["no_data"]:
+            continue
+        yield event["t_us"], event, None
+
+
+def iter_mmap_lines(path: str, stack: ExitStack) -> Iterable[bytes]:
+    """Lines of a recording through a read-only mapping, unmapped when the stack closes."""
+    with open(path, "rb") as replay_fp:
+        if os.fstat(replay_fp.fileno()).st_size == 0:
+            return iter(())
+        mapped = stack.enter_context(mmap.mmap(replay_fp.fileno(), 0, access=mmap.ACCESS_READ))
+    return iter(mapped.readline, b"")
+
+
+def replay_sources(path_spec: str) -> List[Tuple[str, int]]:
+    """Parses QUICKLOOK_REPLAY_PATH into (path, channel offset) pairs.
+
+    Accepts a single recording or capture directory, a comma-separated list where each entry may end
+    in `@<channel offset>` (`board0.ndjson,board1.ndjson@16`), or a `.json` manifest:
+    `{"files": [{"path": "board1.ndjson", "channel_offset": 16}, ...]}`, paths relative to it.
+    """
+    if path_spec.endswith(".json") and os.path.isfile(path_spec):
+        with open(path_spec, "r", encoding="utf-8") as manifest_fp:
+            manifest = json.load(manifest_fp)
+        base = os.path.dirname(path_spec)
+        return [
+            (os.path.join(base, entry["path"]), int(entry.get("channel_offset", 0)))
+            for entry in manifest["files"]
+        ]
+    if os.path.exists(path_spec):
+        return [(path_spec, 0)]
+    sources = []
+    for entry in (part.strip() for part in path_spec.split(",")):
+        if not entry:
+            continue
+        path, _, offset = entry.rpartition("@") if "@" in entry else (entry, "", "0")
+        sources.append((path, int(offset)))
+    return sources
+
+
+def offset_channels(
+    records: Iterable[Tuple[int, dict, Optional[PartialAggregate]]], channel_offset: int
+) -> Iterable[Tuple[int, dict, Optional[PartialAggregate]]]:
+    for t_us, event, partial in records:
+        if partial:
+            for entry in partial.channels:
+                entry.channel += channel_offset
+        elif isinstance(event.get("channel"), int):
+            event["channel"] += channel_offset
+        yield t_us, event, partial
+
+
+def open_replay_source(
+    state: AcquisitionState, path: str, channel_offset: int, stack: ExitStack
+) -> Iterable[Tuple[int, dict, Optional[PartialAggregate]]]:
+    if os.path.isdir(path):
+        records = iter_capture_records(path)
+    else:
+        records = iter_recorded_lines(state, iter_mmap_lines(path, stack))
+    return offset_channels(records, channel_offset) if channel_offset else records
 
 
 def run_replay(state: AcquisitionState) -> None:
     if not state.replay_path:
         state.last_error = "replay path not set"
         return
-    with open(state.replay_path, "r", encoding="utf-8") as replay_fp:
+    with ExitStack() as stack:
+        sources = replay_sources(state.replay_path)
+        streams = [open_replay_source(state, path, offset, stack) for path, offset in sources]
+        # k-way merge on t_us; each recording is already in time order.
+        records = streams[0] if len(streams) == 1 else heapq.merge(*streams, key=itemgetter(0))
         state.connected = True
         last_t_us: Optional[int] = None
-        for line in replay_fp:
+        for t_us, event, partial in records:
             if state.stop_event.is_set():
                 break
-            line = line.strip()
-            if not line:
-                continue
-            try:
-                event = json.loads(line)
-            except json.JSONDecodeError:
-                with state.lock:
-                    state.quality["invalid_json"] += 1
-                    state.quality["invalid_json"] += 1
-                continue
-            t_us = int(event.get("t_us", 0))
-            if last_t_us is not None:
+            if last_t_us is not None and state.replay_speed > 0:
                 delta_us = max(0, t_us - last_t_us)
-                sleep_s = (delta_us / 1_000_000.0) / max(state.replay_speed, 0.01)
+                sleep_s = (delta_us / 1_000_000.0) / state.replay_speed
                 if sleep_s > 0:
                     time.sleep(sleep_s)
             last_t_us = t_us
-            process_event(state, event)
+            if partial:
+                merge_aggregate(state, partial)
+            else:
+                process_record(state, event)
 
 
 def run_acquisition(state: AcquisitionState) -> None:
     state.stop_event.clear()
     state.last_error = None
     state.paused = False
-    state.window.reset()
-    state.rate_history = {}
-    state.rate_history_t_end_us = deque(maxlen=30)
-    # Quality counters are per-run and reset only when a new acquisition starts.
-    state.quality = {
-        "invalid_json": 0,
-        "invalid_channel": 0,
-        "invalid_fields": 0,
-    }
+    continue_restored = state.restored and state.mode != MODE_REPLAY
+    state.restored = False
+    if not continue_restored:
+        state.window.reset()
+        state.run.reset()
+        state.rate_history = empty_rate_history()
+        state.rate_history_t_end_us = deque(maxlen=RATE_HISTORY_LEN)
+        state.serializer.reset_rate_history()
+        if state.rates.max_channels == state.channels:
+            state.rates.reset()
+        else:
+            state.rates = new_rate_ring(state.channels)
+        state.last_hit_us[:] = zero_last_hits()
+        state.last_any_hit_us = 0
+        state.latest_intervals = None
+        # Quality counters are per-run and reset only when a new acquisition starts.
+        state.quality = empty_quality()
+        state.gap = None
+        state.t_offset_us = 0
+        state.transport = TransportStats()
+    timer_speed = state.replay_speed if state.mode == MODE_REPLAY else 1.0
+    timer: Optional[threading.Thread] = None
+    if state.aligned and timer_speed > 0:
+        timer = threading.Thread(target=run_publish_timer, args=(state, timer_speed), name="publish-timer", daemon=True)
+        timer.start()
     try:
         if state.mode == MODE_REPLAY:
             run_replay(state)
@@ -329,7 +860,7 @@ def run_acquisition(state: AcquisitionState) -> None:
                     return
                 record_fp = open(state.record_path, "a", encoding="utf-8")
             try:
-                run_live(state, record_fp)
+                run_live_with_reconnect(state, record_fp)
             finally:
                 if record_fp:
                     record_fp.close()
@@ -337,20 +868,210 @@ def run_acquisition(state: AcquisitionState) -> None:
         state.last_error = str(exc)
     finally:
         state.connected = False
+        if timer is not None:
+            state.stop_event.set()
+            timer.join()
         with state.lock:
             if state.window.t_start_us != 0:
-                state.latest_snapshot = build_snapshot(
-                    state.window,
-                    state.channels,
-                    state.rate_history,
-                    state.rate_history_t_end_us,
-                    state.quality,
-                )
-            state.window.reset()
+                publish_snapshot(state)
+            reset_window(state)
         state.running = False
 
 
+def session_settings(session_id: str, state: AcquisitionState) -> dict:
+    """The SessionCreateRequest that recreates this session's configuration."""
+    return {
+        "session_id": session_id,
+        "mode": state.mode,
+        "sim_host": state.sim_host,
+        "sim_port": state.sim_port,
+        "record_path": state.record_path,
+        "replay_path": state.replay_path,
+        "replay_speed": state.replay_speed,
+        "window_s": state.window_s,
+        "sample_s": state.sample_s,
+        "channels": state.channels,
+        "aligned": state.aligned,
+        "compression": state.compression,
+    }
+
+
+def copy_rate_ring(state: AcquisitionState) -> Tuple[RateRing, int, array]:
+    """Copies the fine rate ring in chunks, taking the lock per chunk so ingest keeps running.
+
+    Rows written meanwhile are stale in the copy; take_checkpoint patches them with finish_copy.
+    """
+    with state.lock:
+        rates = state.rates
+        marked_bin = rates.begin_copy()
+    copy = array("I", bytes(4 * len(rates.counts)))
+    for start in range(0, len(copy), RATE_RING_COPY_CHUNK):
+        with state.lock:
+            copy[start : start + RATE_RING_COPY_CHUNK] = rates.counts[start : start + RATE_RING_COPY_CHUNK]
+    return rates, marked_bin, copy
+
+
+def take_checkpoint(session_id: str, state: AcquisitionState) -> Checkpoint:
+    """Copies the aggregation state for a checkpoint; encoding and writing happen outside the lock.
+
+    The rate ring, most of the state, is copied in chunks beforehand (copy_rate_ring). The final lock
+    hold copies the window, run and interval arrays and re-copies only the ring bins written since.
+    Nothing is folded or published here: the run totals cover completed windows and the window is
+    saved as it stands, so a restore continues both exactly.
+    """
+    copied_rates, marked_bin, rate_counts = copy_rate_ring(state)
+    with state.lock:
+        window = state.window
+        run = state.run
+        rates = state.rates
+        if rates.last_bin < 0:
+            rate_counts = None  # empty ring: zero-filled below, outside the lock
+        elif rates is not copied_rates or not rates.finish_copy(rate_counts, marked_bin):
+            rate_counts = array("I", rates.counts)
+        checkpoint = Checkpoint(
+            channels=state.channels,
+            running=state.running,
+            window_s=window.window_s,
+            sample_s=window.sample_s,
+            saved_at_us=int(time.time() * 1_000_000),
+            t_start_us=window.t_start_us,
+            t_end_us=window.t_end_us,
+            sample_t_start_us=window.sample_t_start_us,
+            sample_t_end_us=window.sample_t_end_us,
+            t_offset_us=state.t_offset_us,
+            counts_by_channel=array("I", window.counts_by_channel),
+            sample_counts_by_channel=array("I", window.sample_counts_by_channel),
+            hists={name: array("I", hist) for name, hist in window.histograms().items()},
+            adc_sums={name: array("Q", sums) for name, sums in window.adc_sums().items()},
+            rate_history=[list(history) for history in state.rate_history],
+            rate_history_t_end_us=list(state.rate_history_t_end_us),
+            quality=dict(state.quality),
+            notes=list(window.notes),
+            run_t_start_us=run.t_start_us,
+            run_t_end_us=run.t_end_us,
+            run_counts_by_channel=array("Q", run.counts_by_channel),
+            run_hists={name: array("Q", hist) for name, hist in run.hists.items()},
+            dt_bins=DT_BINS,
+            hist_dt=array("I", window.hist_dt),
+            hist_dt_global=array("I", window.hist_dt_global),
+            last_hit_us=array("q", state.last_hit_us),
+            last_any_hit_us=state.last_any_hit_us,
+            latest_intervals=state.latest_intervals,
+            rate_bin_us=rates.bin_us,
+            rate_bins=rates.bins,
+            rate_channels=rates.max_channels,
+            rate_last_bin=rates.last_bin,
+            rate_counts=rate_counts,
+            session=session_settings(session_id, state),
+            latest_snapshot=state.latest_snapshot,
+            latest_snapshot_binary=state.latest_snapshot_binary,
+        )
+    if checkpoint.rate_counts is None:
+        checkpoint.rate_counts = array("I", bytes(4 * checkpoint.rate_bins * checkpoint.rate_channels))
+    return checkpoint
+
+
+def copy_prefix(target: array, source: array) -> None:
+    """Copies what fits, so checkpoints saved under a different QUICKLOOK_MAX_CHANNELS keep the arrays' size."""
+    length = min(len(target), len(source))
+    target[:length] = source[:length]
+
+
+def restore_checkpoint(state: AcquisitionState, checkpoint: Checkpoint) -> None:
+    """Loads a checkpoint into an idle state; a later start continues its window."""
+    with state.lock:
+        state.channels = max(MIN_CHANNELS, min(MAX_CHANNELS, checkpoint.channels))
+        state.window_s = checkpoint.window_s
+        state.sample_s = checkpoint.sample_s
+        window = AggregationWindow(window_s=checkpoint.window_s, sample_s=checkpoint.sample_s)
+        window.t_start_us = checkpoint.t_start_us
+        window.t_end_us = checkpoint.t_end_us
+        window.sample_t_start_us = checkpoint.sample_t_start_us
+        window.sample_t_end_us = checkpoint.sample_t_end_us
+        copy_prefix(window.counts_by_channel, checkpoint.counts_by_channel)
+        copy_prefix(window.sample_counts_by_channel, checkpoint.sample_counts_by_channel)
+        for name, hist in window.histograms().items():
+            copy_prefix(hist, checkpoint.hists[name])
+        for name, sums in window.adc_sums().items():
+            copy_prefix(sums, checkpoint.adc_sums[name])
+        window.notes.extend(checkpoint.notes)
+        if checkpoint.dt_bins == DT_BINS:
+            copy_prefix(window.hist_dt, checkpoint.hist_dt)
+            window.hist_dt_global[:] = checkpoint.hist_dt_global
+            copy_prefix(state.last_hit_us, checkpoint.last_hit_us)
+            state.last_any_hit_us = checkpoint.last_any_hit_us
+            if checkpoint.latest_intervals:
+                t_start_us, t_end_us, by_channel, global_hist = checkpoint.latest_intervals
+                latest_by_channel = zero_dt_hist()
+                copy_prefix(latest_by_channel, by_channel)
+                state.latest_intervals = (t_start_us, t_end_us, latest_by_channel, global_hist)
+        state.window = window
+        run = RunAccumulators(t_start_us=checkpoint.run_t_start_us, t_end_us=checkpoint.run_t_end_us)
+        copy_prefix(run.counts_by_channel, checkpoint.run_counts_by_channel)
+        for name, hist in run.hists.items():
+            copy_prefix(hist, checkpoint.run_hists[name])
+        state.run = run
+        # The ring is only usable with the same bin width and length; otherwise it starts empty.
+        rates = new_rate_ring(state.channels)
+        if (
+            checkpoint.rate_bin_us == rates.bin_us
+            and checkpoint.rate_bins == rates.bins
+            and checkpoint.rate_last_bin >= 0
+        ):
+            rates.load_rows(checkpoint.rate_counts, checkpoint.rate_channels)
+            rates.last_bin = checkpoint.rate_last_bin
+            rates.last_slot = (rates.last_bin % rates.bins) * rates.max_channels
+        state.rates = rates
+        state.t_offset_us = checkpoint.t_offset_us
+        state.quality = empty_quality()
+        state.quality.update({key: int(value) for key, value in checkpoint.quality.items() if key in state.quality})
+
+        state.serializer = SnapshotSerializer(state.channels)
+        state.rate_history = empty_rate_history()
+        for channel, history in enumerate(checkpoint.rate_history[:MAX_CHANNELS]):
+            for rate in history:
+                state.rate_history[channel].append(rate)
+                state.serializer.append_rate(channel, rate)
+        state.rate_history_t_end_us = deque(checkpoint.rate_history_t_end_us, maxlen=RATE_HISTORY_LEN)
+        for t_end_us in state.rate_history_t_end_us:
+            state.serializer.append_rate_t_end(t_end_us)
+        state.latest_snapshot = checkpoint.latest_snapshot
+        state.latest_parts = published_from_json(checkpoint.latest_snapshot) if checkpoint.latest_snapshot else None
+        state.latest_snapshot_binary = checkpoint.latest_snapshot_binary
+        state.restored = True
+
+        if checkpoint.running and state.mode != MODE_REPLAY and (window.t_end_us or state.rate_history_t_end_us):
+            # The backend's own downtime is a source gap like any other.
+            begin_gap(state)
+            downtime_s = max(0.0, time.time() - checkpoint.saved_at_us / 1_000_000.0)
+            state.gap.started -= downtime_s
+
+
+def session_checkpoint_path(path: str, session_id: str) -> str:
+    """The default session uses `path` itself; every other session `<path>.session-<session_id>`."""
+    return path if session_id == DEFAULT_SESSION else f"{path}.session-{session_id}"
+
+
+def run_checkpoints(sessions: Dict[str, AcquisitionState], path: str, interval_s: float) -> None:
+    last_saved: Dict[str, tuple] = {}
+    while True:
+        time.sleep(interval_s)
+        for gone in last_saved.keys() - sessions.keys():
+            del last_saved[gone]
+        for session_id, state in list(sessions.items()):
+            # The hub version counts publishes; t_end_us covers ingest between them.
+            key = (state.hub.version, state.window.t_end_us, state.running, state.restored)
+            if last_saved.get(session_id) == key:
+                continue
+            try:
+                write_checkpoint(session_checkpoint_path(path, session_id), take_checkpoint(session_id, state))
+                last_saved[session_id] = key
+            except OSError as exc:
+                print(f"[backend] checkpoint write failed for session {session_id}: {exc}", flush=True)
+
+
 app = FastAPI()
+router = APIRouter()
 
 cors_origins = os.getenv("CORS_ORIGINS", "*")
 origins = [o.strip() for o in cors_origins.split(",") if o.strip()]
@@ -369,6 +1090,9 @@ initial_window_s = int(os.getenv("WINDOW_S", "10"))
 initial_sample_s = int(os.getenv("SAMPLE_S", str(default_sample_s(initial_window_s))))
 initial_sample_s = max(1, min(initial_sample_s, initial_window_s))
 
+# Every session runs its ingest on one of INGEST_THREADS slots; /start fails when all are busy.
+ingest_slots = threading.BoundedSemaphore(INGEST_THREADS)
+
 state = AcquisitionState(
     sim_host=os.getenv("SIM_HOST", "127.0.0.1"),
     sim_port=int(os.getenv("SIM_PORT", "9001")),
@@ -381,23 +1105,103 @@ state = AcquisitionState(
     replay_speed=float(os.getenv("QUICKLOOK_REPLAY_SPEED", "1.0")),
 )
 
+sessions: Dict[str, AcquisitionState] = {DEFAULT_SESSION: state}
+
+
+def session_state(session_id: str = DEFAULT_SESSION) -> AcquisitionState:
+    """Resolves `/sessions/{session_id}/...`; the unprefixed routes use the default session."""
+    session = sessions.get(session_id)
+    if session is None:
+        raise HTTPException(status_code=404, detail=f"no session {session_id!r}")
+    return session
+
+
+def run_ingest(state: AcquisitionState) -> None:
+    try:
+        run_acquisition(state)
+    finally:
+        ingest_slots.release()
+
+
+@app.get("/sessions")
+def list_sessions() -> dict:
+    return {
+        "ingest_threads": INGEST_THREADS,
+        "sessions": {
+            session_id: {"mode": session.mode, "running": session.running, "connected": session.connected}
+            for session_id, session in sessions.items()
+        },
+    }
+
 
-@app.post("/start")
-def start_acquisition() -> dict:
+@app.post("/sessions")
+def create_session(request: SessionCreateRequest) -> dict:
+    if request.session_id in sessions:
+        raise HTTPException(status_code=409, detail=f"session {request.session_id!r} exists")
+    if request.mode not in (MODE_LIVE, MODE_RECORD, MODE_REPLAY):
+        raise HTTPException(status_code=422, detail="mode must be live, record or replay")
+    sample_s = default_sample_s(request.window_s) if request.sample_s is None else request.sample_s
+    if not MIN_WINDOW_S <= request.window_s <= MAX_WINDOW_S or not 1 <= sample_s <= request.window_s:
+        raise HTTPException(status_code=422, detail="window_s or sample_s out of range")
+    if not MIN_CHANNELS <= request.channels <= MAX_CHANNELS:
+        raise HTTPException(status_code=422, detail=f"channels must be between {MIN_CHANNELS} and {MAX_CHANNELS}")
+    if request.compression not in (COMPRESSION_NONE, COMPRESSION_DEFLATE):
+        raise HTTPException(status_code=422, detail="compression must be none or deflate")
+    sessions[request.session_id] = AcquisitionState(
+        sim_host=request.sim_host,
+        sim_port=request.sim_port,
+        window_s=request.window_s,
+        sample_s=sample_s,
+        channels=request.channels,
+        mode=request.mode,
+        record_path=request.record_path,
+        replay_path=request.replay_path,
+        replay_speed=request.replay_speed,
+        aligned=request.aligned,
+        compression=request.compression,
+    )
+    return {"ok": True, "session_id": request.session_id}
+
+
+@app.delete("/sessions/{session_id}")
+def delete_session(session_id: str) -> dict:
+    if session_id == DEFAULT_SESSION:
+        raise HTTPException(status_code=409, detail="the default session cannot be deleted")
+    stop_acquisition(session_state(session_id))
+    del sessions[session_id]
+    if CHECKPOINT_PATH:
+        # Otherwise the next startup would bring the session back.
+        try:
+            os.remove(session_checkpoint_path(CHECKPOINT_PATH, session_id))
+        except FileNotFoundError:
+            pass
+    return {"ok": True}
+
+
+@router.post("/start")
+def start_acquisition(state: AcquisitionState = Depends(session_state)) -> dict:
     if state.running:
         return {"running": True, "paused": state.paused, "connected": state.connected}
+    if not ingest_slots.acquire(blocking=False):
+        raise HTTPException(status_code=409, detail=f"all {INGEST_THREADS} ingest threads are busy")
     state.running = True
     state.paused = False
-    state.thread = threading.Thread(target=run_acquisition, args=(state,), daemon=True)
+    state.thread = threading.Thread(target=run_ingest, args=(state,), daemon=True)
     state.thread.start()
     return {"running": True, "paused": state.paused, "connected": state.connected}
 
 
-@app.post("/stop")
-def stop_acquisition() -> dict:
+@router.post("/stop")
+def stop_acquisition(state: AcquisitionState = Depends(session_state)) -> dict:
     if not state.running:
         return {"running": False, "paused": state.paused, "connected": state.connected}
     state.stop_event.set()
+    sock = state.source_socket
+    if sock:
+        try:
+            sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
     if state.thread and state.thread.is_alive():
         state.thread.join(timeout=2)
     state.running = False
@@ -405,24 +1209,24 @@ def stop_acquisition() -> dict:
     return {"running": False, "paused": state.paused, "connected": state.connected}
 
 
-@app.post("/pause")
-def pause_acquisition() -> dict:
+@router.post("/pause")
+def pause_acquisition(state: AcquisitionState = Depends(session_state)) -> dict:
     if not state.running:
         return {"running": False, "paused": state.paused, "connected": state.connected}
     state.paused = True
     return {"running": state.running, "paused": state.paused, "connected": state.connected}
 
 
-@app.post("/resume")
-def resume_acquisition() -> dict:
+@router.post("/resume")
+def resume_acquisition(state: AcquisitionState = Depends(session_state)) -> dict:
     if not state.running:
         return {"running": False, "paused": state.paused, "connected": state.connected}
     state.paused = False
     return {"running": state.running, "paused": state.paused, "connected": state.connected}
 
 
-@app.get("/status")
-def get_status() -> dict:
+@router.get("/status")
+def get_status(state: AcquisitionState = Depends(session_state)) -> dict:
     return {
         "running": state.running,
         "paused": state.paused,
@@ -432,25 +1236,215 @@ def get_status() -> dict:
         "record_path": state.record_path,
         "replay_path": state.replay_path,
         "replay_speed": state.replay_speed,
+        "stream": state.hub.stats(),
+        "transport": state.transport.as_dict(),
     }
 
 
-@app.get("/snapshot")
-def get_snapshot() -> dict:
+def run_hist_text(total: array, live: array, channel: int) -> str:
+    """One channel's run histogram: completed windows plus the live window."""
+    span = slice(channel * HIST_BINS, (channel + 1) * HIST_BINS)
+    return int_list_text(list(map(int.__add__, total[span], live[span])))
+
+
+def run_snapshot(state: AcquisitionState, channel_ids: List[int], field_names: List[str]) -> bytes:
+    """Run-integrated counts and histograms up to the newest event (`/snapshot?scope=run`).
+
+    The run holds completed windows; the live window is copied with it under the lock and added
+    here, outside it, for the requested channels only.
+    """
     with state.lock:
-        if state.latest_snapshot:
-            return state.latest_snapshot
-    return empty_snapshot(state.window_s, state.sample_s, state.channels)
+        run = state.run
+        window = state.window
+        t_start_us, t_end_us = run.t_start_us, run.t_end_us
+        if window.t_start_us:
+            t_start_us = t_start_us or window.t_start_us
+            t_end_us = max(t_end_us, window.t_end_us)
+        counts = array("Q", run.counts_by_channel)
+        window_counts = array("I", window.counts_by_channel)
+        window_hists = window.histograms()
+        hists = {
+            name: (array("Q", run.hists[name]), array("I", window_hists[name]))
+            for name in HIST_NAMES
+            if f"hist.{name}" in field_names
+        }
+    parts = [
+        b'{"scope":"run","t_start_us":%d,"t_end_us":%d,"channels":' % (t_start_us, t_end_us),
+        int_list_text(channel_ids).encode("ascii"),
+    ]
+    if "counts" in field_names:
+        parts.append(b',"counts_by_channel":{')
+        parts.append(",".join([f'"{ch}":{counts[ch] + window_counts[ch]}' for ch in channel_ids]).encode("ascii"))
+        parts.append(b"}")
+    if hists:
+        parts.append(b',"histograms":{')
+        parts.append(
+            ",".join(
+                [
+                    f'"{name}":{{'
+                    + ",".join([f'"{ch}":' + run_hist_text(total, live, ch) for ch in channel_ids])
+                    + "}"
+                    for name, (total, live) in hists.items()
+                ]
+            ).encode("ascii")
+        )
+        parts.append(b"}")
+    parts.append(b"}")
+    return b"".join(parts)
+
+
+@router.get("/snapshot")
+def get_snapshot(
+    channels: Optional[str] = None,
+    fields: Optional[str] = None,
+    scope: str = "window",
+    state: AcquisitionState = Depends(session_state),
+) -> Response:
+    """Full snapshot, or a projection like `?channels=3,7-12&fields=counts,hist.adc_x,ratemap`.
+
+    `scope=run` returns the run-integrated counts and histograms instead of the rolling window.
+    """
+    if scope not in ("window", "run"):
+        raise HTTPException(status_code=422, detail="scope must be window or run")
+    if scope == "run":
+        try:
+            channel_ids = list(range(state.channels)) if channels is None else parse_channels(channels, state.channels)
+            field_names = parse_fields(fields if fields is not None else "counts,hist")
+        except ValueError as exc:
+            raise HTTPException(status_code=422, detail=str(exc)) from exc
+        return Response(content=run_snapshot(state, channel_ids, field_names), media_type="application/json")
+
+    with state.lock:
+        body = state.latest_snapshot
+        parts = state.latest_parts
+    if channels is None and fields is None:
+        if body is None:
+            body = empty_snapshot(state.window_s, state.sample_s, state.channels)
+        return Response(content=body, media_type="application/json")
+
+    if parts is None:
+        parts = empty_snapshot_parts(state.window_s, state.sample_s, state.channels)
+    published_channels = len(parts.counts.ends)
+    try:
+        channel_ids = list(range(published_channels)) if channels is None else parse_channels(channels, published_channels)
+        field_names = parse_fields(fields if fields is not None else ",".join(SNAPSHOT_FIELDS))
+    except ValueError as exc:
+        raise HTTPException(status_code=422, detail=str(exc)) from exc
+    return Response(content=parts.project(channel_ids, field_names), media_type="application/json")
+
+
+@router.get("/snapshot/stream")
+async def stream_snapshots(
+    channels: Optional[str] = None,
+    fields: Optional[str] = None,
+    max_hz: float = 0.0,
+    state: AcquisitionState = Depends(session_state),
+) -> StreamingResponse:
+    """Server-sent events, one `snapshot` event per published sample (at most `max_hz` per second)."""
+    try:
+        channel_ids = None if channels is None else parse_channels(channels, state.channels)
+        if fields is not None:
+            field_names = parse_fields(fields)
+        else:
+            field_names = list(SNAPSHOT_FIELDS) if channel_ids is not None else []
+    except ValueError as exc:
+        raise HTTPException(status_code=422, detail=str(exc)) from exc
+    if max_hz < 0:
+        raise HTTPException(status_code=422, detail="max_hz must be >= 0")
+    if state.hub.version == 0 and state.latest_parts is not None:
+        state.hub.publish(state.latest_parts)
+    return StreamingResponse(
+        state.hub.stream(filter_key(channel_ids, field_names), 1.0 / max_hz if max_hz > 0 else 0.0),
+        media_type="text/event-stream",
+        headers={"Cache-Control": "no-cache"},
+    )
+
+
+@router.get("/snapshot/thumbnails")
+def get_snapshot_thumbnails(channels: Optional[str] = None, state: AcquisitionState = Depends(session_state)) -> Response:
+    """Counts and 16-bin histograms per channel for overview grids; fetch `/snapshot?channels=...` for full bins."""
+    with state.lock:
+        parts = state.latest_parts
+    if parts is None:
+        parts = empty_snapshot_parts(state.window_s, state.sample_s, state.channels)
+    published_channels = len(parts.counts.ends)
+    try:
+        channel_ids = list(range(published_channels)) if channels is None else parse_channels(channels, published_channels)
+    except ValueError as exc:
+        raise HTTPException(status_code=422, detail=str(exc)) from exc
+    return Response(content=parts.thumbnail_view(channel_ids), media_type="application/json")
+
+
+@router.get("/snapshot/binary")
+def get_snapshot_binary(state: AcquisitionState = Depends(session_state)) -> Response:
+    with state.lock:
+        body = state.latest_snapshot_binary
+    if body is None:
+        raise HTTPException(status_code=404, detail="no snapshot published yet")
+    return Response(content=body, media_type="application/octet-stream")
+
+
+@router.get("/rates/fine")
+def get_fine_rates(
+    channels: Optional[str] = None,
+    seconds: float = 60.0,
+    width: int = 800,
+    state: AcquisitionState = Depends(session_state),
+) -> Response:
+    """Binary per-channel counts in QUICKLOOK_RATE_BIN_MS bins, min/max downsampled to `width` columns."""
+    if width < 1 or width > 65535 or seconds <= 0:
+        raise HTTPException(status_code=422, detail="width must be 1..65535 and seconds > 0")
+    try:
+        channel_ids = list(range(state.channels)) if channels is None else parse_channels(channels, state.channels)
+    except ValueError as exc:
+        raise HTTPException(status_code=422, detail=str(exc)) from exc
+    with state.lock:
+        # /config may have rebuilt the ring for fewer channels since channel_ids was parsed.
+        rates = state.rates
+        bins = int(seconds * 1_000_000) // rates.bin_us
+        t_end_us = rates.t_end_us()
+        channel_series = [
+            (channel, rates.series(channel, bins)) for channel in channel_ids if channel < rates.max_channels
+        ]
+    return Response(
+        content=encode_rates(rates.bin_us, t_end_us, channel_series, width),
+        media_type="application/octet-stream",
+    )
 
 
-@app.get("/config")
-def get_config() -> dict:
+@router.get("/intervals")
+def get_intervals(channels: Optional[str] = None, state: AcquisitionState = Depends(session_state)) -> dict:
+    """Log2 inter-arrival histograms of the window as of the latest published sample."""
+    try:
+        channel_ids = list(range(state.channels)) if channels is None else parse_channels(channels, state.channels)
+    except ValueError as exc:
+        raise HTTPException(status_code=422, detail=str(exc)) from exc
+    with state.lock:
+        intervals = state.latest_intervals
+    if intervals is None:
+        t_start_us, t_end_us, by_channel, global_hist = 0, 0, zero_dt_hist(), zero_dt_global()
+    else:
+        t_start_us, t_end_us, by_channel, global_hist = intervals
+    return {
+        "t_start_us": t_start_us,
+        "t_end_us": t_end_us,
+        "bin_lower_us": [0] + [1 << (k - 1) for k in range(1, DT_BINS)],
+        "global": global_hist.tolist(),
+        "by_channel": {
+            str(channel): by_channel[channel * DT_BINS : (channel + 1) * DT_BINS].tolist() for channel in channel_ids
+        },
+    }
+
+
+@router.get("/config")
+def get_config(state: AcquisitionState = Depends(session_state)) -> dict:
     return {
         "sim_host": state.sim_host,
         "sim_port": state.sim_port,
         "window_s": state.window_s,
         "sample_s": state.sample_s,
         "channels": state.channels,
+        "aligned": state.aligned,
         "mode": state.mode,
         "record_path": state.record_path,
         "replay_path": state.replay_path,
@@ -465,12 +1459,12 @@ def get_config() -> dict:
     }
 
 
-@app.post("/config")
-def update_config(request: ConfigUpdateRequest) -> dict:
+@router.post("/config")
+def update_config(request: ConfigUpdateRequest, state: AcquisitionState = Depends(session_state)) -> dict:
     if state.running:
         raise HTTPException(status_code=409, detail="stop acquisition before updating config")
 
-    if request.window_s is None and request.sample_s is None and request.channels is None:
+    if request.window_s is None and request.sample_s is None and request.channels is None and request.aligned is None:
         raise HTTPException(status_code=400, detail="no settings provided")
 
     next_window_s = state.window_s if request.window_s is None else request.window_s
@@ -499,16 +1493,75 @@ def update_config(request: ConfigUpdateRequest) -> dict:
         state.window_s = next_window_s
         state.sample_s = next_sample_s
         state.channels = next_channels
+        if request.aligned is not None:
+            state.aligned = request.aligned
         state.window.window_s = next_window_s
         state.window.sample_s = next_sample_s
-        state.window.reset()
-        state.latest_snapshot = empty_snapshot(state.window_s, state.sample_s, state.channels)
-        state.rate_history = {}
-        state.rate_history_t_end_us = deque(maxlen=30)
+        reset_window(state)
+        state.serializer = SnapshotSerializer(state.channels)
+        state.latest_parts = empty_snapshot_parts(state.window_s, state.sample_s, state.channels)
+        state.latest_snapshot = state.latest_parts.full()
+        state.hub.publish(state.latest_parts)
+        state.latest_snapshot_binary = None
+        state.rate_history = empty_rate_history()
+        state.rate_history_t_end_us = deque(maxlen=RATE_HISTORY_LEN)
+        if state.rates.max_channels != state.channels:
+            state.rates = new_rate_ring(state.channels)
 
     return {
         "ok": True,
         "window_s": state.window_s,
         "sample_s": state.sample_s,
         "channels": state.channels,
+        "aligned": state.aligned,
     }
+
+
+app.include_router(router)
+app.include_router(router, prefix="/sessions/{session_id}")
+
+
+def restore_sessions(path: str) -> List[AcquisitionState]:
+    """Loads the default session's checkpoint and recreates every other checkpointed session.
+
+    Returns the sessions that were running when they were saved.
+    """
+    resume: List[AcquisitionState] = []
+    session_paths = [(DEFAULT_SESSION, path)]
+    prefix = session_checkpoint_path(path, "")
+    directory = os.path.dirname(path) or "."
+    for name in sorted(os.listdir(directory)) if os.path.isdir(directory) else []:
+        full = os.path.join(os.path.dirname(path), name)
+        session_id = full[len(prefix) :] if full.startswith(prefix) else ""
+        if re.match(SESSION_ID_PATTERN, session_id) and session_id != DEFAULT_SESSION:
+            session_paths.append((session_id, full))
+    for session_id, session_path in session_paths:
+        try:
+            checkpoint = read_checkpoint(session_path)
+        except (OSError, CheckpointFormatError) as exc:
+            print(f"[backend] ignoring checkpoint {session_path}: {exc}", flush=True)
+            continue
+        if checkpoint is None:
+            continue
+        if session_id != DEFAULT_SESSION:
+            try:
+                create_session(SessionCreateRequest(**{**checkpoint.session, "session_id": session_id}))
+            except (ValueError, HTTPException) as exc:
+                print(f"[backend] ignoring checkpoint {session_path}: {exc}", flush=True)
+                continue
+        session = sessions[session_id]
+        restore_checkpoint(session, checkpoint)
+        if checkpoint.running:
+            resume.append(session)
+    return resume
+
+
+if CHECKPOINT_PATH:
+    for resumed in restore_sessions(CHECKPOINT_PATH):
+        start_acquisition(resumed)
+    threading.Thread(
+        target=run_checkpoints,
+        args=(sessions, CHECKPOINT_PATH, CHECKPOINT_INTERVAL_S),
+        name="checkpoint",
+        daemon=True,
+    ).start()
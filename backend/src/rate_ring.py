@@ -0,0 +1,171 @@
+"""Fine-grained per-channel rate time series for burst detection.
+
+Counts are kept in fixed bins of event time (10 ms by default) in a ring covering the last few
+minutes. The ring is bin-major (`slot * max_channels + channel`, one row per bin sized by the
+session's channel count), so recording an event is one increment at an index derived from `t_us`,
+and retiring a bin clears one contiguous row. An empty ring (`last_bin == -1`) is all zeros, so
+`reset()` and the first event skip the full clear.
+`GET /rates/fine` reads it back min/max downsampled to the client's pixel width.
+"""
+
+from __future__ import annotations
+
+import struct
+import sys
+from array import array
+from typing import List, Sequence, Tuple
+
+RATES_MAGIC = b"QLR1"
+RATES_VERSION = 2
+# magic, version, channel count, columns, bin_us, bins per column, t_end_us (end of newest bin)
+RATES_HEADER = struct.Struct("<4sHHHIIq")
+
+
+class RateRing:
+    def __init__(self, bin_us: int, bins: int, max_channels: int) -> None:
+        self.bin_us = max(1, bin_us)
+        self.bins = max(1, bins)
+        self.max_channels = max_channels
+        self._zero_row = array("I", bytes(4 * max_channels))
+        self.counts = array("I", bytes(4 * max_channels * self.bins))
+        # Absolute index (t_us // bin_us) of the newest bin, or -1 before the first event, and
+        # its offset in `counts`; events in the newest bin are the hot path (see process_event).
+        self.last_bin = -1
+        self.last_slot = 0
+        # Lowest absolute bin written since begin_copy(); -1 when a copy has to start over.
+        self.dirty_from = -1
+
+    def reset(self) -> None:
+        if self.last_bin >= 0:
+            self.counts[:] = array("I", bytes(4 * self.max_channels * self.bins))
+        self.last_bin = -1
+        self.last_slot = 0
+        self.dirty_from = -1
+
+    def advance(self, new_bin: int) -> None:
+        """Makes `new_bin` the newest bin, clearing the bins it retires."""
+        if self.last_bin >= 0 and new_bin - self.last_bin >= self.bins:
+            self.counts[:] = array("I", bytes(4 * self.max_channels * self.bins))
+        elif self.last_bin >= 0:
+            row = self.max_channels
+            for absolute in range(self.last_bin + 1, new_bin + 1):
+                slot = (absolute % self.bins) * row
+                self.counts[slot : slot + row] = self._zero_row
+        self.last_bin = new_bin
+        self.last_slot = (new_bin % self.bins) * self.max_channels
+
+    def load_rows(self, counts: array, stride: int) -> None:
+        """Copies a saved ring whose rows hold `stride` channels; extra channels are dropped."""
+        if stride == self.max_channels:
+            self.counts[:] = counts
+            return
+        width = min(stride, self.max_channels)
+        for slot in range(self.bins):
+            self.counts[slot * self.max_channels : slot * self.max_channels + width] = counts[
+                slot * stride : slot * stride + width
+            ]
+
+    def slot_index(self, t_us: int) -> int:
+        """Index into `counts` of channel 0 in the bin holding t_us; -1 if older than the ring."""
+        absolute = t_us // self.bin_us
+        if absolute > self.last_bin:
+            self.advance(absolute)
+        elif absolute <= self.last_bin - self.bins:
+            return -1
+        elif absolute < self.dirty_from:
+            self.dirty_from = absolute
+        return (absolute % self.bins) * self.max_channels
+
+    def begin_copy(self) -> int:
+        """Starts a copy of `counts` taken in chunks while events keep arriving; pass the result to finish_copy."""
+        self.dirty_from = self.last_bin
+        return self.last_bin
+
+    def finish_copy(self, copy: array, marked_bin: int) -> bool:
+        """Re-copies the bins written since begin_copy(); False if too much changed and a full copy is needed.
+
+        Only bins from the marked newest bin onwards change, plus late events, which lower `dirty_from`.
+        """
+        if marked_bin < 0 or self.dirty_from < 0 or self.last_bin - self.dirty_from >= self.bins:
+            return False
+        row = self.max_channels
+        for absolute in range(self.dirty_from, self.last_bin + 1):
+            slot = (absolute % self.bins) * row
+            copy[slot : slot + row] = self.counts[slot : slot + row]
+        return True
+
+    def add_spread(self, t_start_us: int, t_end_us: int, channel: int, count: int) -> None:
+        """Spreads a pre-aggregated count evenly over the bins its slice covers."""
+        first = t_start_us // self.bin_us
+        last = max(first, t_end_us // self.bin_us)
+        spans = last - first + 1
+        share, extra = divmod(count, spans)
+        for offset, absolute in enumerate(range(first, last + 1)):
+            value = share + (1 if offset < extra else 0)
+            if value:
+                slot = self.slot_index(absolute * self.bin_us)
+                if slot >= 0:
+                    self.counts[slot + channel] += value
+
+    def t_end_us(self) -> int:
+        """End of the newest bin, or 0 before the first event."""
+        return (self.last_bin + 1) * self.bin_us if self.last_bin >= 0 else 0
+
+    def series(self, channel: int, bins: int) -> array:
+        """Counts of the newest `bins` bins for one channel, oldest first."""
+        bins = min(bins, self.bins, self.last_bin + 1)
+        if bins <= 0:
+            return array("I")
+        column = self.counts[channel :: self.max_channels]
+        end = self.last_bin % self.bins + 1
+        if bins <= end:
+            return column[end - bins : end]
+        return column[self.bins - (bins - end) :] + column[:end]
+
+
+def downsample_min_max(series: array, columns: int) -> Tuple[array, array]:
+    """Per-column min and max over `columns` equal spans of `series` (len(series) >= columns)."""
+    mins, maxs = array("I"), array("I")
+    length = len(series)
+    for column in range(columns):
+        span = series[column * length // columns : (column + 1) * length // columns]
+        mins.append(min(span))
+        maxs.append(max(span))
+    return mins, maxs
+
+
+def encode_rates(
+    bin_us: int,
+    t_end_us: int,
+    channel_series: Sequence[Tuple[int, array]],
+    width: int,
+) -> bytes:
+    """Little-endian: header, u16 channel ids[C] (padded to 4 bytes), then per channel u32 min[W], u32 max[W]."""
+    bins = max((len(series) for _, series in channel_series), default=0)
+    columns = max(0, min(width, bins))
+    bins_per_column = bins // columns if columns else 0
+    parts: List[bytes] = [
+        RATES_HEADER.pack(
+            RATES_MAGIC,
+            RATES_VERSION,
+            len(channel_series),
+            columns,
+            bin_us,
+            bins_per_column,
+            t_end_us,
+        )
+    ]
+    ids = array("H", (channel for channel, _ in channel_series))
+    if sys.byteorder == "big":
+        ids.byteswap()
+    parts.append(ids.tobytes() + bytes(-2 * len(ids) % 4))
+    for _, series in channel_series:
+        if columns == 0:
+            continue
+        mins, maxs = downsample_min_max(series, columns)
+        if sys.byteorder == "big":
+            mins.byteswap()
+            maxs.byteswap()
+        parts.append(mins.tobytes())
+        parts.append(maxs.tobytes())
+    return b"".join(parts)
@@ -0,0 +1,401 @@
+"""Direct-to-bytes snapshot serialization.
+
+The aggregation engine keeps its counters in flat uint32 arrays (`channel * HIST_BINS + bin`).
+Instead of building a nested dict per sample boundary and letting FastAPI encode it generically,
+the serializer writes the snapshot JSON from those arrays with precomputed key/structure text.
+The per-channel blocks (counts and histograms) are written by `backend/native/snapshot_native.c`
+when the shared library is built (`make backend-native`), otherwise by an equivalent Python path.
+Rate history text is kept incrementally, so each published rate is formatted exactly once.
+Per-channel sections keep the end offset of every channel's fragment, so projections
+(`/snapshot?channels=...&fields=...`) are answered by slicing the published bytes. The same holds
+for the reduced-resolution histogram thumbnails behind `/snapshot/thumbnails`.
+"""
+
+from __future__ import annotations
+
+import ctypes
+import json
+import os
+import struct
+import sys
+from array import array
+from collections import deque
+from dataclasses import dataclass, field
+from functools import lru_cache
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Sequence
+
+HIST_BINS = 64
+HIST_NAMES = ("adc_x", "adc_gtop", "adc_gbot")
+RATE_HISTORY_LEN = 30
+# Bins per histogram in the overview thumbnails; each sums HIST_BINS // THUMBNAIL_BINS adjacent bins.
+THUMBNAIL_BINS = 16
+
+BINARY_MAGIC = b"QLS1"
+BINARY_VERSION = 1
+# magic, version, channels, window_s, sample_s, t_start_us, t_end_us
+BINARY_HEADER = struct.Struct("<4sHHIIqq")
+
+NATIVE_LIBRARY = Path(
+    os.getenv("QUICKLOOK_NATIVE_LIB", str(Path(__file__).with_name("_snapshot_native.so")))
+)
+
+
+def load_native() -> Optional[ctypes.CDLL]:
+    if not NATIVE_LIBRARY.exists():
+        return None
+    try:
+        lib = ctypes.CDLL(str(NATIVE_LIBRARY))
+    except OSError:
+        return None
+    lib.ql_write_channel_values.restype = ctypes.c_size_t
+    lib.ql_write_channel_values.argtypes = [
+        ctypes.c_void_p,
+        ctypes.c_void_p,
+        ctypes.c_size_t,
+        ctypes.c_size_t,
+        ctypes.c_char_p,
+        ctypes.c_size_t,
+        ctypes.c_void_p,
+    ]
+    return lib
+
+
+native = load_native()
+
+
+def int_list_text(values: Iterable[int]) -> str:
+    return "[" + ",".join(map(str, values)) + "]"
+
+
+def float_list_text(values: Iterable[float]) -> str:
+    return "[" + ",".join(map(repr, values)) + "]"
+
+
+def little_endian_bytes(values: array) -> bytes:
+    if sys.byteorder == "big":
+        values = array(values.typecode, values)
+        values.byteswap()
+    return values.tobytes()
+
+
+# Projection field names; "hist" selects all three histograms.
+SNAPSHOT_FIELDS = (
+    "counts",
+    "hist.adc_x",
+    "hist.adc_gtop",
+    "hist.adc_gbot",
+    "ratemap",
+    "spatial",
+    "rate_history",
+    "quality",
+    "notes",
+)
+
+
+def parse_fields(text: str) -> List[str]:
+    fields = set()
+    for name in (part.strip() for part in text.split(",")):
+        if name == "hist":
+            fields.update(f"hist.{hist}" for hist in HIST_NAMES)
+        elif name in SNAPSHOT_FIELDS:
+            fields.add(name)
+        elif name:
+            raise ValueError(f"unknown field {name!r}")
+    return [name for name in SNAPSHOT_FIELDS if name in fields]
+
+
+def parse_channels(text: str, channels: int) -> List[int]:
+    """Parses `3,7-12` into sorted channel ids below `channels`."""
+    selected = set()
+    for part in (part.strip() for part in text.split(",")):
+        if not part:
+            continue
+        first, _, last = part.partition("-")
+        low, high = int(first), int(last or first)
+        if low < 0 or high < low:
+            raise ValueError(f"bad channel range {part!r}")
+        selected.update(range(low, min(high, channels - 1) + 1))
+    return sorted(selected)
+
+
+@dataclass
+class ChannelSection:
+    """Comma-joined per-channel fragments for channels 0..n-1; `ends[ch]` is where ch's ends."""
+
+    text: bytes
+    ends: array
+
+    def select(self, channel_ids: Sequence[int]) -> bytes:
+        text, ends = self.text, self.ends
+        return b",".join([text[ends[ch - 1] + 1 if ch else 0 : ends[ch]] for ch in channel_ids])
+
+
+@dataclass
+class PublishedSnapshot:
+    head: bytes
+    channels_text: bytes
+    counts: ChannelSection
+    hists: Dict[str, ChannelSection]
+    ratemap: bytes
+    rate_history: ChannelSection
+    rate_t_end: bytes
+    quality: bytes
+    notes: bytes
+    spatial: bytes = b"null"
+    thumbnails: Dict[str, ChannelSection] = field(default_factory=dict)
+
+    def full(self) -> bytes:
+        hists = self.hists
+        return b"".join(
+            [
+                self.head,
+                b',"channels":',
+                self.channels_text,
+                b',"counts_by_channel":{',
+                self.counts.text,
+                b'},"histograms":{"adc_x":{',
+                hists["adc_x"].text,
+                b'},"adc_gtop":{',
+                hists["adc_gtop"].text,
+                b'},"adc_gbot":{',
+                hists["adc_gbot"].text,
+                b'}},"ratemap_8x8":[',
+                self.ratemap,
+                b'],"spatial":',
+                self.spatial,
+                b',"rate_history":{',
+                self.rate_history.text,
+                b'},"rate_history_t_end_us":[',
+                self.rate_t_end,
+                b'],"quality":{',
+                self.quality,
+                b'},"notes":',
+                self.notes,
+                b"}",
+            ]
+        )
+
+    def project(self, channel_ids: Sequence[int], fields: Sequence[str]) -> bytes:
+        """Same layout as `full()`, restricted to the given channels and fields (see parse_fields)."""
+        parts = [self.head, b',"channels":', int_list_text(channel_ids).encode("ascii")]
+        if "counts" in fields:
+            parts += [b',"counts_by_channel":{', self.counts.select(channel_ids), b"}"]
+        hist_names = [name for name in HIST_NAMES if f"hist.{name}" in fields]
+        if hist_names:
+            parts.append(b',"histograms":{')
+            parts.append(
+                b",".join(
+                    [b'"%s":{%s}' % (name.encode("ascii"), self.hists[name].select(channel_ids)) for name in hist_names]
+                )
+            )
+            parts.append(b"}")
+        if "ratemap" in fields:
+            parts += [b',"ratemap_8x8":[', self.ratemap, b"]"]
+        if "spatial" in fields:
+            parts += [b',"spatial":', self.spatial]
+        if "rate_history" in fields:
+            parts += [
+                b',"rate_history":{',
+                self.rate_history.select(channel_ids),
+                b'},"rate_history_t_end_us":[',
+                self.rate_t_end,
+                b"]",
+            ]
+        if "quality" in fields:
+            parts += [b',"quality":{', self.quality, b"}"]
+        if "notes" in fields:
+            parts += [b',"notes":', self.notes]
+        parts.append(b"}")
+        return b"".join(parts)
+
+    def thumbnail_view(self, channel_ids: Sequence[int]) -> bytes:
+        """Counts and THUMBNAIL_BINS-bin histograms of the given channels."""
+        parts = [
+            self.head,
+            b',"channels":',
+            int_list_text(channel_ids).encode("ascii"),
+            b',"counts_by_channel":{',
+            self.counts.select(channel_ids),
+            b'},"thumbnail_bins":%d,"thumbnails":{' % THUMBNAIL_BINS,
+            b",".join(
+                [b'"%s":{%s}' % (name.encode("ascii"), self.thumbnails[name].select(channel_ids)) for name in HIST_NAMES]
+            ),
+            b"}}",
+        ]
+        return b"".join(parts)
+
+
+def fold_bins(values: Sequence[int], factor: int) -> List[int]:
+    """Sums each run of `factor` adjacent values."""
+    return list(map(sum, zip(*(values[offset::factor] for offset in range(factor)))))
+
+
+def published_from_json(body: bytes) -> PublishedSnapshot:
+    """Rebuilds the sections of a full snapshot, e.g. one loaded from a checkpoint."""
+    snapshot = json.loads(body)
+    channel_ids = snapshot["channels"]
+
+    def section(values: Dict[str, object], render) -> ChannelSection:
+        return joined_section([f'"{ch}":' + render(values[str(ch)]) for ch in channel_ids])
+
+    return PublishedSnapshot(
+        head=b'{"window_s":%d,"sample_s":%d,"t_start_us":%d,"t_end_us":%d'
+        % (snapshot["window_s"], snapshot["sample_s"], snapshot["t_start_us"], snapshot["t_end_us"]),
+        channels_text=int_list_text(channel_ids).encode("ascii"),
+        counts=section(snapshot["counts_by_channel"], str),
+        hists={name: section(snapshot["histograms"][name], int_list_text) for name in HIST_NAMES},
+        ratemap=",".join([float_list_text(row) for row in snapshot["ratemap_8x8"]]).encode("ascii"),
+        rate_history=section(snapshot["rate_history"], float_list_text),
+        rate_t_end=",".join(map(str, snapshot["rate_history_t_end_us"])).encode("ascii"),
+        quality=",".join([f'"{key}":{value}' for key, value in snapshot["quality"].items()]).encode("ascii"),
+        notes=json.dumps(snapshot["notes"], ensure_ascii=False, separators=(",", ":")).encode("utf-8"),
+        spatial=json.dumps(snapshot.get("spatial"), separators=(",", ":")).encode("ascii"),
+        thumbnails={
+            name: section(
+                snapshot["histograms"][name], lambda hist: int_list_text(fold_bins(hist, HIST_BINS // THUMBNAIL_BINS))
+            )
+            for name in HIST_NAMES
+        },
+    )
+
+
+def joined_section(fragments: List[str]) -> ChannelSection:
+    ends = array("I")
+    offset = -1
+    for fragment in fragments:
+        offset += len(fragment) + 1
+        ends.append(offset)
+    return ChannelSection(",".join(fragments).encode("ascii"), ends)
+
+
+@dataclass(frozen=True)
+class ChannelLayout:
+    """Precomputed key/structure text for a channel count, shared by every serializer using it."""
+
+    channel_ids: array
+    channel_keys: List[str]
+    channels_text: bytes
+
+
+@lru_cache(maxsize=None)
+def channel_layout(channels: int) -> ChannelLayout:
+    return ChannelLayout(
+        channel_ids=array("i", range(channels)),
+        channel_keys=[f'"{channel}":' for channel in range(channels)],
+        channels_text=int_list_text(range(channels)).encode("ascii"),
+    )
+
+
+class SnapshotSerializer:
+    """Serializes snapshots for a fixed channel count; create a new one when `channels` changes.
+
+    The layout text is shared across sessions; rate history text and the native output buffer are
+    per serializer, since sessions publish from their own threads.
+    """
+
+    def __init__(self, channels: int) -> None:
+        self.channels = channels
+        layout = channel_layout(channels)
+        self.channel_ids = layout.channel_ids
+        self.channel_keys = layout.channel_keys
+        self.channels_text = layout.channels_text
+        self.reset_rate_history()
+        # Worst case for one block of channels x HIST_BINS u32 values, reused across publishes.
+        self._out_capacity = channels * (16 + HIST_BINS * 11) + 64
+        self._out = ctypes.create_string_buffer(self._out_capacity)
+        self._ends = array("I", bytes(4 * channels))
+
+    def reset_rate_history(self) -> None:
+        self.rate_text: List[deque] = [deque(maxlen=RATE_HISTORY_LEN) for _ in range(self.channels)]
+        self.rate_t_end_text: deque = deque(maxlen=RATE_HISTORY_LEN)
+
+    def append_rate(self, channel: int, rate: float) -> None:
+        if channel < self.channels:
+            self.rate_text[channel].append(repr(rate))
+
+    def append_rate_t_end(self, t_end_us: int) -> None:
+        self.rate_t_end_text.append(str(t_end_us))
+
+    def channel_values(self, values: array, bins: int) -> ChannelSection:
+        """`"ch":v` (bins == 1) or `"ch":[...]` for every channel, comma-separated."""
+        channel_ids = self.channel_ids
+        if native is not None:
+            ids_addr, count = channel_ids.buffer_info()
+            written = native.ql_write_channel_values(
+                values.buffer_info()[0],
+                ids_addr,
+                count,
+                bins,
+                self._out,
+                self._out_capacity,
+                self._ends.buffer_info()[0],
+            )
+            if written or count == 0:
+                return ChannelSection(self._out.raw[:written], array("I", self._ends))
+        keys = self.channel_keys
+        if bins == 1:
+            return joined_section([keys[ch] + str(values[ch]) for ch in channel_ids])
+        return joined_section([keys[ch] + int_list_text(values[ch * bins : (ch + 1) * bins]) for ch in channel_ids])
+
+    def serialize_parts(
+        self,
+        window_s: int,
+        sample_s: int,
+        t_start_us: int,
+        t_end_us: int,
+        counts: array,
+        hists: Dict[str, array],
+        ratemap: Sequence[Sequence[float]],
+        quality: Dict[str, int],
+        notes: Sequence[str],
+        spatial: bytes = b"null",
+    ) -> PublishedSnapshot:
+        """`spatial` is the precomputed JSON text of the spatial products (backend/src/spatial.py)."""
+        keys = self.channel_keys
+        rate_text = self.rate_text
+        return PublishedSnapshot(
+            head=b'{"window_s":%d,"sample_s":%d,"t_start_us":%d,"t_end_us":%d'
+            % (window_s, sample_s, t_start_us, t_end_us),
+            channels_text=self.channels_text,
+            counts=self.channel_values(counts, 1),
+            hists={name: self.channel_values(hists[name], HIST_BINS) for name in HIST_NAMES},
+            ratemap=",".join([float_list_text(row) for row in ratemap]).encode("ascii"),
+            rate_history=joined_section(
+                [keys[ch] + "[" + ",".join(rate_text[ch]) + "]" for ch in range(self.channels)]
+            ),
+            rate_t_end=",".join(self.rate_t_end_text).encode("ascii"),
+            quality=",".join([f'"{key}":{value}' for key, value in quality.items()]).encode("ascii"),
+            notes=json.dumps(list(notes), ensure_ascii=False, separators=(",", ":")).encode("utf-8"),
+            spatial=spatial,
+            thumbnails={name: self.thumbnail_values(hists[name]) for name in HIST_NAMES},
+        )
+
+    def thumbnail_values(self, hist: array) -> ChannelSection:
+        folded = fold_bins(hist[: self.channels * HIST_BINS], HIST_BINS // THUMBNAIL_BINS)
+        return self.channel_values(array("I", folded), THUMBNAIL_BINS)
+
+    def serialize(self, *args, **kwargs) -> bytes:
+        """Full snapshot JSON; same arguments as `serialize_parts`."""
+        return self.serialize_parts(*args, **kwargs).full()
+
+    def serialize_binary(
+        self,
+        window_s: int,
+        sample_s: int,
+        t_start_us: int,
+        t_end_us: int,
+        counts: array,
+        hists: Dict[str, array],
+        ratemap: Sequence[Sequence[float]],
+    ) -> bytes:
+        """Little-endian layout: header, u32 counts[channels], u32 hist[3][channels][64], f32 ratemap[64]."""
+        channels = self.channels
+        parts = [
+            BINARY_HEADER.pack(BINARY_MAGIC, BINARY_VERSION, channels, window_s, sample_s, t_start_us, t_end_us),
+            little_endian_bytes(counts[:channels]),
+        ]
+        for name in HIST_NAMES:
+            parts.append(little_endian_bytes(hists[name][: channels * HIST_BINS]))
+        parts.append(little_endian_bytes(array("f", [value for row in ratemap for value in row])))
+        return b"".join(parts)
@@ -0,0 +1,105 @@
+"""Server-sent snapshot push with per-client channel/field subscriptions.
+
+The acquisition thread hands every published snapshot to the hub, which bumps a version and wakes
+the stream generators on the event loop. Each subscription is keyed by its (channels, fields)
+filter; the projected payload for a key is built once per version by whichever subscriber asks
+first and reused by the rest, so the projection work grows with the number of distinct filters,
+not with the number of clients.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import threading
+from collections import Counter
+from typing import AsyncIterator, Dict, Optional, Sequence, Tuple
+
+from .snapshot_serializer import PublishedSnapshot
+
+FilterKey = Tuple[Optional[Tuple[int, ...]], Tuple[str, ...]]
+
+# Sent when nothing was published for this long, so proxies keep the connection open.
+KEEPALIVE_S = 15.0
+
+
+class SnapshotHub:
+    def __init__(self) -> None:
+        self.version = 0
+        self._parts: Optional[PublishedSnapshot] = None
+        self._payloads: Dict[FilterKey, bytes] = {}
+        self._lock = threading.Lock()
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._changed: Optional[asyncio.Event] = None
+        self.subscriptions: Counter = Counter()
+
+    def publish(self, parts: PublishedSnapshot) -> None:
+        """Called from the acquisition thread after each publish; does no serialization itself."""
+        with self._lock:
+            self.version += 1
+            self._parts = parts
+            self._payloads = {}
+            loop = self._loop
+        if loop is not None and not loop.is_closed():
+            loop.call_soon_threadsafe(self._notify)
+
+    def _notify(self) -> None:
+        changed, self._changed = self._changed, asyncio.Event()
+        if changed is not None:
+            changed.set()
+
+    def payload(self, key: FilterKey) -> Tuple[int, Optional[bytes]]:
+        """(version, SSE message) for a filter, built at most once per version."""
+        with self._lock:
+            version, parts = self.version, self._parts
+            cached = self._payloads.get(key)
+        if parts is None:
+            return version, None
+        if cached is not None:
+            return version, cached
+        channels, fields = key
+        channel_ids = range(len(parts.counts.ends)) if channels is None else channels
+        body = parts.project(channel_ids, fields) if channels is not None or fields else parts.full()
+        message = b"id: %d\nevent: snapshot\ndata: %s\n\n" % (version, body)
+        with self._lock:
+            if self.version == version:
+                message = self._payloads.setdefault(key, message)
+        return version, message
+
+    async def stream(self, key: FilterKey, min_interval_s: float) -> AsyncIterator[bytes]:
+        if self._loop is None:
+            self._loop = asyncio.get_running_loop()
+            self._changed = asyncio.Event()
+        self.subscriptions[key] += 1
+        sent_version = -1
+        try:
+            while True:
+                changed = self._changed
+                if self.version == sent_version:
+                    try:
+                        await asyncio.wait_for(changed.wait(), KEEPALIVE_S)
+                    except asyncio.TimeoutError:
+                        yield b": keepalive\n\n"
+                        continue
+                version, message = self.payload(key)
+                if message is None:
+                    sent_version = version
+                    continue
+                sent_version = version
+                yield message
+                if min_interval_s > 0:
+                    await asyncio.sleep(min_interval_s)
+        finally:
+            self.subscriptions[key] -= 1
+            if self.subscriptions[key] <= 0:
+                del self.subscriptions[key]
+
+    def stats(self) -> Dict[str, int]:
+        return {
+            "subscribers": sum(self.subscriptions.values()),
+            "distinct_filters": len(self.subscriptions),
+            "version": self.version,
+        }
+
+
+def filter_key(channel_ids: Optional[Sequence[int]], fields: Sequence[str]) -> FilterKey:
+    return (None if channel_ids is None else tuple(channel_ids), tuple(fields))
@@ -0,0 +1,93 @@
+"""Spatial products on the module's pixel grid, derived from the window counters at publish time.
+
+Nothing here runs per event: at each sample boundary the per-channel counts and exact ADC sums kept
+by ingest are folded into row/column projections, per-pixel mean ADC maps and neighbour-sum maps,
+in O(pixels).
+The geometry comes from `QUICKLOOK_GEOMETRY`: `ROWSxCOLS` (channels fill the grid row-major, as in
+`ratemap_8x8`) or the path of a JSON file `{"rows": R, "cols": C, "pixels": [[row, col], ...]}`
+listing the pixel of each channel in channel order.
+"""
+
+from __future__ import annotations
+
+import json
+from array import array
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+from .snapshot_serializer import HIST_NAMES, float_list_text, int_list_text
+
+@dataclass(frozen=True)
+class Geometry:
+    rows: int
+    cols: int
+    # Pixel (row, col) of each channel; channels past the end are not on the grid.
+    pixels: Tuple[Tuple[int, int], ...]
+
+
+def load_geometry(spec: str, max_channels: int) -> Geometry:
+    if "x" in spec and not spec.endswith(".json"):
+        rows, cols = (int(part) for part in spec.lower().split("x", 1))
+        pixels = tuple(divmod(channel, cols) for channel in range(min(max_channels, rows * cols)))
+        return Geometry(rows, cols, pixels)
+    with open(spec, "r", encoding="utf-8") as geometry_fp:
+        config = json.load(geometry_fp)
+    rows, cols = int(config["rows"]), int(config["cols"])
+    pixels = tuple((int(row), int(col)) for row, col in config["pixels"][:max_channels])
+    for row, col in pixels:
+        if not (0 <= row < rows and 0 <= col < cols):
+            raise ValueError(f"pixel ({row}, {col}) outside {rows}x{cols} grid")
+    return Geometry(rows, cols, pixels)
+
+
+def grid_text(grid: List[List[float]]) -> str:
+    return "[" + ",".join(float_list_text(row) for row in grid) + "]"
+
+
+def spatial_text(geometry: Geometry, channels: int, counts: array, adc_sums: Dict[str, array]) -> bytes:
+    """The snapshot's `spatial` object for the window counts and per-channel ADC sums, as JSON text."""
+    rows, cols = geometry.rows, geometry.cols
+    count_grid = [[0] * cols for _ in range(rows)]
+    mean_grids = {name: [[0.0] * cols for _ in range(rows)] for name in HIST_NAMES}
+    for channel, (row, col) in enumerate(geometry.pixels[:channels]):
+        count = counts[channel]
+        count_grid[row][col] = count
+        if count:
+            for name in HIST_NAMES:
+                mean_grids[name][row][col] = round(adc_sums[name][channel] / count, 1)
+
+    neighbour_grid = [[0] * cols for _ in range(rows)]
+    for row in range(rows):
+        for col in range(cols):
+            total = 0
+            if row > 0:
+                total += count_grid[row - 1][col]
+            if row + 1 < rows:
+                total += count_grid[row + 1][col]
+            if col > 0:
+                total += count_grid[row][col - 1]
+            if col + 1 < cols:
+                total += count_grid[row][col + 1]
+            neighbour_grid[row][col] = total
+
+    row_projection = [sum(row) for row in count_grid]
+    col_projection = [sum(count_grid[row][col] for row in range(rows)) for col in range(cols)]
+    return "".join(
+        [
+            f'{{"rows":{rows},"cols":{cols},"row_projection":',
+            int_list_text(row_projection),
+            ',"col_projection":',
+            int_list_text(col_projection),
+            ',"mean_adc":{',
+            ",".join(f'"{name}":' + grid_text(mean_grids[name]) for name in HIST_NAMES),
+            '},"neighbour_sum":[',
+            ",".join(int_list_text(row) for row in neighbour_grid),
+            "]}",
+        ]
+    ).encode("ascii")
+
+
+def empty_spatial_text(geometry: Optional[Geometry]) -> bytes:
+    if geometry is None:
+        return b"null"
+    return spatial_text(geometry, 0, array("I"), {name: array("Q") for name in HIST_NAMES})
@@ -0,0 +1,118 @@
+"""Optional framed deflate layer on the live source stream (docs/02-Data-Contract.md, section D).
+
+The receiver asks for compression with a hello line right after connecting. A sender that agrees
+answers with `QLZ1` and from then on sends frames of one raw deflate stream, primed with
+`COMPRESS_DICTIONARY` and flushed (Z_SYNC_FLUSH) at every frame end. A sender that does not know
+the hello ignores it and sends plain NDJSON, so either side can be upgraded first. The hello names
+the dictionary by its CRC-32, and a sender whose copy differs answers with plain output instead of
+a stream this side could not decode. The decoded
+bytes are the same NDJSON / aggregate-frame stream as without compression.
+"""
+
+from __future__ import annotations
+
+import io
+import socket
+import struct
+import time
+import zlib
+from dataclasses import dataclass
+from typing import BinaryIO, Dict, Tuple
+
+COMPRESSION_NONE = "none"
+COMPRESSION_DEFLATE = "deflate"
+COMPRESS_MAGIC = b"QLZ1"
+# compressed payload length, decoded length
+COMPRESS_FRAME_HEADER = struct.Struct("<II")
+# Refuse frames larger than this; senders cap blocks at 32 KiB.
+MAX_FRAME_BYTES = 1 << 20
+# Two typical event lines. Must match the simulator's and the adapter's copy byte for byte.
+COMPRESS_DICTIONARY = (
+    b'{"t_us":1700000000000123,"channel":3,"adc_x":1712,"adc_gtop":2540,"adc_gbot":2466,'
+    b'"flags":{"trg_x":true,"trg_g":true,"no_data":false,"is_g_event":true}}\n'
+    b'{"t_us":1700000000000000,"channel":12,"adc_x":2048,"adc_gtop":2311,"adc_gbot":1998,'
+    b'"flags":{"trg_x":false,"trg_g":false,"no_data":false,"is_g_event":false}}\n'
+)
+COMPRESS_DICTIONARY_ID = f"{zlib.crc32(COMPRESS_DICTIONARY):08x}"
+COMPRESS_HELLO = f"QLHELLO compress=deflate dict={COMPRESS_DICTIONARY_ID}\n".encode("ascii")
+
+
+class CompressionFormatError(OSError):
+    pass
+
+
+@dataclass
+class TransportStats:
+    """Receiver-side counters, cumulative over reconnects."""
+
+    compression: str = COMPRESSION_NONE
+    frames: int = 0
+    wire_bytes: int = 0
+    raw_bytes: int = 0
+    cpu_s: float = 0.0
+
+    def as_dict(self) -> Dict[str, object]:
+        return {
+            "compression": self.compression,
+            "frames": self.frames,
+            "wire_bytes": self.wire_bytes,
+            "raw_bytes": self.raw_bytes,
+            "ratio": round(self.raw_bytes / self.wire_bytes, 2) if self.wire_bytes else None,
+            "decompress_cpu_s": round(self.cpu_s, 3),
+        }
+
+
+class DeflateFrameReader(io.RawIOBase):
+    """Raw stream of the decoded bytes; wrap it in io.BufferedReader for peek/readline."""
+
+    def __init__(self, wire: BinaryIO, stats: TransportStats) -> None:
+        self._wire = wire
+        self._stats = stats
+        self._inflate = zlib.decompressobj(wbits=-15, zdict=COMPRESS_DICTIONARY)
+        self._pending = b""
+
+    def readable(self) -> bool:
+        return True
+
+    def readinto(self, buffer) -> int:
+        while not self._pending:
+            header = self._wire.read(COMPRESS_FRAME_HEADER.size)
+            if len(header) < COMPRESS_FRAME_HEADER.size:
+                return 0
+            wire_length, raw_length = COMPRESS_FRAME_HEADER.unpack(header)
+            if wire_length > MAX_FRAME_BYTES or raw_length > MAX_FRAME_BYTES:
+                raise CompressionFormatError("compressed frame too large")
+            payload = self._wire.read(wire_length)
+            if len(payload) < wire_length:
+                return 0
+            cpu_start = time.thread_time()
+            try:
+                decoded = self._inflate.decompress(payload)
+            except zlib.error as exc:
+                raise CompressionFormatError(f"bad compressed frame: {exc}") from exc
+            stats = self._stats
+            stats.cpu_s += time.thread_time() - cpu_start
+            if len(decoded) != raw_length:
+                raise CompressionFormatError("compressed frame length mismatch")
+            stats.frames += 1
+            stats.wire_bytes += COMPRESS_FRAME_HEADER.size + wire_length
+            stats.raw_bytes += raw_length
+            self._pending = decoded
+        count = min(len(buffer), len(self._pending))
+        buffer[:count] = self._pending[:count]
+        self._pending = self._pending[count:]
+        return count
+
+
+def open_source_stream(sock: socket.socket, compression: str, stats: TransportStats) -> Tuple[BinaryIO, str]:
+    """Negotiates the transport on a fresh connection; returns the decoded byte stream and the mode used."""
+    wire = sock.makefile("rb")
+    if compression != COMPRESSION_DEFLATE:
+        return wire, COMPRESSION_NONE
+    sock.sendall(COMPRESS_HELLO)
+    # NDJSON starts with "{" and aggregate frames with 0x1E, so only the magic starts with "Q".
+    if wire.peek(1)[:1] != COMPRESS_MAGIC[:1]:
+        return wire, COMPRESSION_NONE
+    if wire.read(len(COMPRESS_MAGIC)) != COMPRESS_MAGIC:
+        raise CompressionFormatError("bad compression magic")
+    return io.BufferedReader(DeflateFrameReader(wire, stats), buffer_size=65536), COMPRESSION_DEFLATE
@@ -1,6 +1,7 @@
-import { useEffect, useMemo, useRef, useState } from "react";
+import { useCallback, useEffect, useMemo, useRef, useState } from "react";
 import { ChannelDetailModal } from "./components/ChannelDetailModal";
-import { MiniPlotChart } from "./components/Plots";
+import { ChannelGrid } from "./components/ChannelGrid";
+import { MiniPlotChart, ThumbnailBars } from "./components/Plots";
 import { useElementSize } from "./components/useElementSize";
 
 type Snapshot = {
@@ -21,6 +22,15 @@ type Snapshot = {
   notes: string[];
 };
 
+type HistogramKey = "adc_x" | "adc_gtop" | "adc_gbot";
+
+// GET /snapshot/thumbnails: reduced-resolution spectra for the overview tiles.
+type Thumbnails = {
+  thumbnail_bins: number;
+  counts_by_channel: Record<string, number>;
+  thumbnails: Record<HistogramKey, Record<string, number[]>>;
+};
+
 type Status = {
   running: boolean;
   paused: boolean;
@@ -42,32 +52,41 @@ type BackendConfig = {
 
 const backendUrl = import.meta.env.VITE_BACKEND_URL || "http://localhost:8000";
 
-const defaultChannels = Array.from({ length: 64 }, (_, index) => index);
+// The channel list comes from the backend; histograms and rate history are only held for the
+// channels currently fetched at full resolution (see detailFields).
 const defaultSnapshot: Snapshot = {
   window_s: 10,
   sample_s: 10,
   t_start_us: 0,
   t_end_us: 0,
-  channels: defaultChannels,
-  counts_by_channel: Object.fromEntries(defaultChannels.map((ch) => [String(ch), 0])),
-  histograms: {
-    adc_x: Object.fromEntries(defaultChannels.map((ch) => [String(ch), Array(64).fill(0)])),
-    adc_gtop: Object.fromEntries(defaultChannels.map((ch) => [String(ch), Array(64).fill(0)])),
-    adc_gbot: Object.fromEntries(defaultChannels.map((ch) => [String(ch), Array(64).fill(0)])),
-  },
+  channels: [],
+  counts_by_channel: {},
+  histograms: { adc_x: {}, adc_gtop: {}, adc_gbot: {} },
   ratemap_8x8: Array.from({ length: 8 }, () => Array.from({ length: 8 }, () => 0)),
-  rate_history: Object.fromEntries(defaultChannels.map((ch) => [String(ch), []])),
+  rate_history: {},
   rate_history_t_end_us: [],
   notes: ["waiting for data"],
 };
 
-const histogramStreams: Array<{ key: "adc_x" | "adc_gtop" | "adc_gbot"; label: string }> = [
+const defaultThumbnails: Thumbnails = {
+  thumbnail_bins: 16,
+  counts_by_channel: {},
+  thumbnails: { adc_x: {}, adc_gtop: {}, adc_gbot: {} },
+};
+
+// Polled for every channel: one number per channel plus the fixed-size ratemap.
+const overviewFields = "counts,ratemap,notes";
+// Polled only for the channels shown at full resolution (histogram table, tiles in view, modals).
+const detailFields = "counts,hist,rate_history";
+
+const histogramStreams: Array<{ key: HistogramKey; label: string }> = [
   { key: "adc_x", label: "adc_x" },
   { key: "adc_gtop", label: "adc_gtop" },
   { key: "adc_gbot", label: "adc_gbot" },
 ];
 
 const HISTOGRAM_BIN_COUNT = 64;
+const COUNT_BARS_MAX = 64;
 
 const clamp = (value: number, min: number, max: number) => Math.min(max, Math.max(min, value));
 
@@ -120,9 +139,10 @@ const ensureRatemap = (ratemap?: number[][]) => {
   return ratemap.map((row) => row.map((value) => (Number.isFinite(value) ? value : 0)));
 };
 
-const normalizeHistogramRecord = (record?: Record<string, number[]>, channels: number[] = defaultChannels) =>
+// Keeps only the channels present in `record`, so projections stay as small as what was fetched.
+const normalizeHistogramRecord = (record: Record<string, number[]> | undefined, channels: number[]) =>
   Object.fromEntries(
-    channels.map((channel) => {
+    channels.filter((channel) => record?.[String(channel)] !== undefined).map((channel) => {
       const values = record?.[String(channel)] ?? [];
       const normalizedValues = Array.isArray(values)
         ? values.slice(0, HISTOGRAM_BIN_COUNT).map((value) => (Number.isFinite(value) ? value : 0))
@@ -144,7 +164,7 @@ const normalizeSnapshot = (data?: Partial<Snapshot>) => {
   const channels =
     Array.isArray(data.channels) && data.channels.length > 0
       ? data.channels.filter((value) => Number.isFinite(value))
-      : defaultChannels;
+      : [];
 
   return {
     window_s: Number.isFinite(data.window_s) ? data.window_s! : defaultSnapshot.window_s,
@@ -162,12 +182,12 @@ const normalizeSnapshot = (data?: Partial<Snapshot>) => {
     },
     ratemap_8x8: ensureRatemap(data.ratemap_8x8),
     rate_history: Object.fromEntries(
-      channels.map((channel) => [
-        String(channel),
-        Array.isArray(data.rate_history?.[String(channel)])
-          ? data.rate_history?.[String(channel)]?.map((value) => (Number.isFinite(value) ? value : 0)) ?? []
-          : [],
-      ])
+      channels
+        .filter((channel) => Array.isArray(data.rate_history?.[String(channel)]))
+        .map((channel) => [
+          String(channel),
+          data.rate_history?.[String(channel)]?.map((value) => (Number.isFinite(value) ? value : 0)) ?? [],
+        ])
     ),
     rate_history_t_end_us: Array.isArray(data.rate_history_t_end_us)
       ? data.rate_history_t_end_us.filter((value) => Number.isFinite(value))
@@ -176,6 +196,31 @@ const normalizeSnapshot = (data?: Partial<Snapshot>) => {
   };
 };
 
+const normalizeThumbnails = (data?: Partial<Thumbnails>): Thumbnails => ({
+  thumbnail_bins: Number.isFinite(data?.thumbnail_bins) ? data!.thumbnail_bins! : defaultThumbnails.thumbnail_bins,
+  counts_by_channel: data?.counts_by_channel ?? {},
+  thumbnails: {
+    adc_x: data?.thumbnails?.adc_x ?? {},
+    adc_gtop: data?.thumbnails?.adc_gtop ?? {},
+    adc_gbot: data?.thumbnails?.adc_gbot ?? {},
+  },
+});
+
+// `3,4,5,9` -> `3-5,9` for the `channels` query parameter.
+const formatChannelRanges = (channels: number[]) => {
+  const sorted = [...new Set(channels)].sort((a, b) => a - b);
+  const parts: string[] = [];
+  for (let index = 0; index < sorted.length; ) {
+    let end = index;
+    while (end + 1 < sorted.length && sorted[end + 1] === sorted[end] + 1) {
+      end += 1;
+    }
+    parts.push(end === index ? String(sorted[index]) : `${sorted[index]}-${sorted[end]}`);
+    index = end + 1;
+  }
+  return parts.join(",");
+};
+
 const normalizeStatus = (data?: Partial<Status>) => ({
   running: Boolean(data?.running),
   paused: Boolean(data?.paused),
@@ -197,13 +242,18 @@ const getModeYAxisMax = (snapshot: Snapshot, mode: MultiChannelPlotMode, channel
 
 function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
   const [status, setStatus] = useState<Status>({ running: false, paused: false, connected: false });
-  const [snapshot, setSnapshot] = useState<Snapshot>(defaultSnapshot);
+  const [overview, setOverview] = useState<Snapshot>(defaultSnapshot);
+  const [detail, setDetail] = useState<Snapshot>(defaultSnapshot);
+  const [thumbnails, setThumbnails] = useState<Thumbnails>(defaultThumbnails);
   const [lastStatusAt, setLastStatusAt] = useState<Date | null>(null);
   const [lastSnapshotAt, setLastSnapshotAt] = useState<Date | null>(null);
   const [selectedChannel, setSelectedChannel] = useState<number | null>(null);
   const [modalOpen, setModalOpen] = useState(false);
   const [recentChannels, setRecentChannels] = useState<number[]>([]);
   const [pageIndex, setPageIndex] = useState(0);
+  const [gridRange, setGridRange] = useState({ first: 0, last: 0 });
+  const [monitorDetailChannels, setMonitorDetailChannels] = useState<number[]>([]);
+  const [overviewStream, setOverviewStream] = useState<HistogramKey>("adc_x");
   const [settingsError, setSettingsError] = useState<string | null>(null);
   const [savingSettings, setSavingSettings] = useState(false);
   const [settings, setSettings] = useState<BackendConfig>({
@@ -217,6 +267,50 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
       max_channels: 64,
     },
   });
+  // `channels` query values for the polled projections, read by the timers.
+  const detailQueryRef = useRef("");
+  const thumbnailQueryRef = useRef("");
+
+  const fetchOverview = useCallback(() => {
+    fetch(`${backendUrl}/snapshot?fields=${overviewFields}`)
+      .then((res) => res.json())
+      .then((data: Snapshot) => {
+        setOverview(normalizeSnapshot(data));
+        setLastSnapshotAt(new Date());
+      })
+      .catch(() => setOverview((prev) => ({ ...prev, notes: ["snapshot fetch failed"] })));
+  }, []);
+
+  const fetchDetail = useCallback(() => {
+    const query = detailQueryRef.current;
+    if (!query) {
+      setDetail(defaultSnapshot);
+      return;
+    }
+    fetch(`${backendUrl}/snapshot?channels=${query}&fields=${detailFields}`)
+      .then((res) => res.json())
+      .then((data: Snapshot) => {
+        if (query === detailQueryRef.current) {
+          setDetail(normalizeSnapshot(data));
+        }
+      })
+      .catch(() => undefined);
+  }, []);
+
+  const fetchThumbnails = useCallback(() => {
+    const query = thumbnailQueryRef.current;
+    if (!query) {
+      return;
+    }
+    fetch(`${backendUrl}/snapshot/thumbnails?channels=${query}`)
+      .then((res) => res.json())
+      .then((data: Thumbnails) => {
+        if (query === thumbnailQueryRef.current) {
+          setThumbnails(normalizeThumbnails(data));
+        }
+      })
+      .catch(() => undefined);
+  }, []);
 
   useEffect(() => {
     const fetchStatus = () => {
@@ -246,7 +340,7 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
             ...prev,
             window_s: data.window_s,
             sample_s: data.sample_s,
-            channels: 64,
+            channels: data.channels,
             limits: data.limits ?? prev.limits,
           }));
         })
@@ -254,13 +348,9 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
     };
 
     const fetchSnapshot = () => {
-      fetch(`${backendUrl}/snapshot`)
-        .then((res) => res.json())
-        .then((data: Snapshot) => {
-          setSnapshot(normalizeSnapshot(data));
-          setLastSnapshotAt(new Date());
-        })
-        .catch(() => setSnapshot((prev) => ({ ...prev, notes: ["snapshot fetch failed"] })));
+      fetchOverview();
+      fetchDetail();
+      fetchThumbnails();
     };
 
     fetchStatus();
@@ -274,13 +364,28 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
       clearInterval(statusTimer);
       clearInterval(snapshotTimer);
     };
-  }, []);
-
-  const channels = useMemo(() => defaultChannels, []);
-  const rawCountsMax = Math.max(1, ...channels.map((ch) => snapshot.counts_by_channel[String(ch)] || 0));
+  }, [fetchDetail, fetchOverview, fetchThumbnails]);
+
+  const channelKey = overview.channels.join(",");
+  const channels = useMemo(() => overview.channels, [channelKey]);
+  const countBars = useMemo(() => {
+    // At most COUNT_BARS_MAX bars; with more channels each bar sums a contiguous group.
+    const groupSize = Math.max(1, Math.ceil(channels.length / COUNT_BARS_MAX));
+    const bars: Array<{ first: number; last: number; count: number }> = [];
+    for (let index = 0; index < channels.length; index += groupSize) {
+      const group = channels.slice(index, index + groupSize);
+      bars.push({
+        first: group[0],
+        last: group[group.length - 1],
+        count: group.reduce((sum, ch) => sum + (overview.counts_by_channel[String(ch)] || 0), 0),
+      });
+    }
+    return { groupSize, bars };
+  }, [channels, overview.counts_by_channel]);
+  const rawCountsMax = Math.max(1, ...countBars.bars.map((bar) => bar.count));
   const countsMax = niceCeil(rawCountsMax * 1.06);
-  const heatMax = Math.max(1, ...snapshot.ratemap_8x8.flat());
-  const heatMin = Math.min(...snapshot.ratemap_8x8.flat());
+  const heatMax = Math.max(1, ...overview.ratemap_8x8.flat());
+  const heatMin = Math.min(...overview.ratemap_8x8.flat());
 
   const histogramPageSize = 4;
   const orderedChannels = useMemo(() => {
@@ -297,6 +402,41 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
     }
   }, [maxPageIndex, pageIndex]);
 
+  // Full resolution only for what is on screen: the histogram table rows and the modal channel, or
+  // the monitor wall tiles in view.
+  const detailQuery = formatChannelRanges(
+    viewMode === "monitor"
+      ? monitorDetailChannels
+      : [...visibleHistogramChannels, ...(selectedChannel !== null ? [selectedChannel] : [])]
+  );
+  const thumbnailQuery = formatChannelRanges(channels.slice(gridRange.first, gridRange.last));
+
+  useEffect(() => {
+    detailQueryRef.current = detailQuery;
+    // Debounced, so scrolling through the grid does not fire a request per row.
+    const timer = window.setTimeout(fetchDetail, 120);
+    return () => window.clearTimeout(timer);
+  }, [detailQuery, fetchDetail]);
+
+  useEffect(() => {
+    thumbnailQueryRef.current = thumbnailQuery;
+    const timer = window.setTimeout(fetchThumbnails, 120);
+    return () => window.clearTimeout(timer);
+  }, [thumbnailQuery, fetchThumbnails]);
+
+  const onGridRangeChange = useCallback((first: number, last: number) => setGridRange({ first, last }), []);
+
+  // Overview counts for every channel, histograms and rate history for the detail channels.
+  const snapshot = useMemo<Snapshot>(
+    () => ({
+      ...overview,
+      histograms: detail.histograms,
+      rate_history: detail.rate_history,
+      rate_history_t_end_us: detail.rate_history_t_end_us,
+    }),
+    [detail, overview]
+  );
+
   const updateRecentChannels = (channelNumber: number) => {
     setRecentChannels((prev) => [channelNumber, ...prev.filter((channel) => channel !== channelNumber)].slice(0, 4));
     setPageIndex(0);
@@ -341,7 +481,7 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
         body: JSON.stringify({
           window_s: Math.round(settings.window_s),
           sample_s: Math.round(settings.sample_s),
-          channels: 64,
+          channels: Math.round(settings.channels),
         }),
       });
       const payload = await response.json();
@@ -353,10 +493,11 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
         ...prev,
         window_s: payload.window_s,
         sample_s: payload.sample_s,
-        channels: 64,
+        channels: payload.channels,
       }));
-      const freshSnapshot = await fetch(`${backendUrl}/snapshot`).then((res) => res.json());
-      setSnapshot(normalizeSnapshot(freshSnapshot));
+      fetchOverview();
+      fetchDetail();
+      fetchThumbnails();
       setPageIndex(0);
     } catch {
       setSettingsError("Failed to save settings");
@@ -372,7 +513,16 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
   };
 
   if (viewMode === "monitor") {
-    return <MonitorWall snapshot={snapshot} status={status} />;
+    return (
+      <MonitorWall
+        snapshot={snapshot}
+        channels={channels}
+        thumbnails={thumbnails}
+        status={status}
+        onGridRangeChange={onGridRangeChange}
+        onDetailChannelsChange={setMonitorDetailChannels}
+      />
+    );
   }
 
   return (
@@ -447,6 +597,18 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
                 }
               />
             </label>
+            <label>
+              <span>Channels</span>
+              <input
+                type="number"
+                min={settings.limits?.min_channels ?? 1}
+                max={settings.limits?.max_channels ?? 64}
+                value={settings.channels}
+                onChange={(event) =>
+                  setSettings((prev) => ({ ...prev, channels: Number(event.target.value) }))
+                }
+              />
+            </label>
             <button type="button" onClick={saveSettings} disabled={status.running || savingSettings}>
               {savingSettings ? "Saving..." : "Apply"}
             </button>
@@ -461,20 +623,21 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
             <div>
               <h2>Counts per Channel (accumulated in window)</h2>
               <p className="subtitle">
-                Updated every {snapshot.sample_s}s, resets every {snapshot.window_s}s · {channels.length} channels · linear scale · auto max ({formatRateMax(countsMax)} counts)
+                Updated every {snapshot.sample_s}s, resets every {snapshot.window_s}s · {channels.length} channels
+                {countBars.groupSize > 1 ? ` (${countBars.groupSize} per bar)` : null} · linear scale · auto max ({formatRateMax(countsMax)} counts)
               </p>
             </div>
           </div>
-          <div className="bar-chart-64">
-            {channels.map((ch) => {
-              const count = snapshot.counts_by_channel[String(ch)] || 0;
-              const height = (count / countsMax) * 100;
+          <div className="bar-chart-64" style={{ gridTemplateColumns: `repeat(${Math.max(1, countBars.bars.length)}, minmax(6px, 1fr))` }}>
+            {countBars.bars.map((bar, barIndex) => {
+              const height = (bar.count / countsMax) * 100;
+              const label = bar.first === bar.last ? `ch ${bar.first}` : `ch ${bar.first}-${bar.last}`;
               return (
-                <div key={ch} className="bar-item-64" title={`ch ${ch}: ${count} counts`}>
+                <div key={bar.first} className="bar-item-64" title={`${label}: ${bar.count} counts`}>
                   <div className="bar-track-64">
                     <div className="bar-64" style={{ height: `${height}%` }} />
                   </div>
-                  {ch % 8 === 0 ? <span>ch {ch}</span> : <span className="bar-label-spacer" aria-hidden="true" />}
+                  {barIndex % 8 === 0 ? <span>ch {bar.first}</span> : <span className="bar-label-spacer" aria-hidden="true" />}
                 </div>
               );
             })}
@@ -497,6 +660,54 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
           />
         </section>
 
+        <section className="panel overview-panel">
+          <div className="panel-header">
+            <div>
+              <h2>Channel Overview</h2>
+              <p className="subtitle">
+                {channels.length} channels · {thumbnails.thumbnail_bins}-bin {overviewStream.toUpperCase()} thumbnails · click a
+                tile for the full-resolution view
+              </p>
+            </div>
+            <label className="overview-stream">
+              <span>Spectrum</span>
+              <select value={overviewStream} onChange={(event) => setOverviewStream(event.target.value as HistogramKey)}>
+                {histogramStreams.map((stream) => (
+                  <option key={stream.key} value={stream.key}>
+                    {stream.label.toUpperCase()}
+                  </option>
+                ))}
+              </select>
+            </label>
+          </div>
+          <ChannelGrid
+            className="overview-grid"
+            channels={channels}
+            minTileWidth={124}
+            tileHeight={78}
+            gap={6}
+            onRangeChange={onGridRangeChange}
+            renderTile={(ch) => (
+              <button
+                type="button"
+                className="overview-tile"
+                onClick={() => {
+                  updateRecentChannels(ch);
+                  openModal(ch);
+                }}
+              >
+                <span className="overview-tile-header">
+                  <strong>ch {ch}</strong>
+                  <span>{(overview.counts_by_channel[String(ch)] ?? 0).toFixed(0)}</span>
+                </span>
+                <ThumbnailBars
+                  data={thumbnails.thumbnails[overviewStream][String(ch)] ?? Array(thumbnails.thumbnail_bins).fill(0)}
+                />
+              </button>
+            )}
+          />
+        </section>
+
         <section className="panel histograms-panel">
           <div className="panel-header">
             <div>
@@ -607,10 +818,19 @@ function App({ viewMode = "dashboard" }: { viewMode?: ViewMode }) {
 
 function MonitorWall({
   snapshot,
+  channels,
+  thumbnails,
   status,
+  onGridRangeChange,
+  onDetailChannelsChange,
 }: {
   snapshot: Snapshot;
+  channels: number[];
+  thumbnails: Thumbnails;
   status: Status;
+  onGridRangeChange: (first: number, last: number) => void;
+  // Channels to fetch at full resolution: the tiles in view and the focused channel.
+  onDetailChannelsChange: (channels: number[]) => void;
 }) {
   const [plotMode, setPlotMode] = useState<MultiChannelPlotMode>("adc_x");
   const [focusedChannelIndex, setFocusedChannelIndex] = useState<number | null>(null);
@@ -621,7 +841,22 @@ function MonitorWall({
     adc_gbot: 1,
     rate_vs_time: 1,
   });
-  const channels = snapshot.channels.length > 0 ? snapshot.channels : defaultChannels;
+  const [range, setRange] = useState({ first: 0, last: 0 });
+
+  const onRangeChange = useCallback(
+    (first: number, last: number) => {
+      setRange({ first, last });
+      onGridRangeChange(first, last);
+    },
+    [onGridRangeChange]
+  );
+
+  const focusedChannel = focusedChannelIndex === null ? null : channels[focusedChannelIndex] ?? null;
+
+  useEffect(() => {
+    const inView = channels.slice(range.first, range.last);
+    onDetailChannelsChange(focusedChannel === null ? inView : [...inView, focusedChannel]);
+  }, [channels, focusedChannel, onDetailChannelsChange, range]);
 
   useEffect(() => {
     setLockedYAxisByMode((prev) => ({
@@ -665,14 +900,12 @@ function MonitorWall({
     setFocusedChannelIndex(nextIndex);
   };
 
-  const focusedChannel = focusedChannelIndex === null ? null : channels[focusedChannelIndex];
-
   return (
     <div className="monitor-app">
       <header className="monitor-header">
         <div>
           <p className="monitor-kicker">Quicklook Monitor Window</p>
-          <h1>64-Channel Multi-Plot Wall</h1>
+          <h1>{channels.length}-Channel Multi-Plot Wall</h1>
           <p>
             Live secondary display for operations · {channels.length} detected channels · {modeMeta[plotMode].title}
           </p>
@@ -702,16 +935,23 @@ function MonitorWall({
         </span>
       </section>
 
-      <main className="monitor-grid">
-        {channels.map((channel, index) => {
+      <ChannelGrid
+        className="monitor-grid"
+        channels={channels}
+        minTileWidth={240}
+        tileHeight={272}
+        onRangeChange={onRangeChange}
+        renderTile={(channel, index) => {
           const isRate = plotMode === "rate_vs_time";
+          // Full resolution once the tile's detail fetch lands; the thumbnail until then.
           const chartData = isRate
             ? snapshot.rate_history[String(channel)] ?? []
-            : snapshot.histograms[plotMode][String(channel)] ?? Array(64).fill(0);
+            : snapshot.histograms[plotMode][String(channel)] ?? thumbnails.thumbnails[plotMode][String(channel)] ?? [];
+          const yMax =
+            isRate || snapshot.histograms[plotMode][String(channel)] !== undefined ? currentYAxisMax : undefined;
 
           return (
             <article
-              key={channel}
               className="monitor-card"
               onClick={() => openFocusedChart(index)}
               role="button"
@@ -729,15 +969,15 @@ function MonitorWall({
               </div>
               <div className="monitor-card-chart">
                 {isRate ? (
-                  <MiniPlotChart kind="line" data={chartData} yMax={currentYAxisMax} showXAxisLabel showYAxisLabel />
+                  <MiniPlotChart kind="line" data={chartData} yMax={yMax} showXAxisLabel showYAxisLabel />
                 ) : (
-                  <MiniPlotChart kind="histogram" data={chartData} yMax={currentYAxisMax} showXAxisLabel showYAxisLabel />
+                  <MiniPlotChart kind="histogram" data={chartData} yMax={yMax} showXAxisLabel showYAxisLabel />
                 )}
               </div>
             </article>
           );
-        })}
-      </main>
+        }}
+      />
 
       <MonitorChartModal
         open={focusedChannel !== null}
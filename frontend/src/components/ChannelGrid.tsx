@@ -0,0 +1,82 @@
+import { ReactNode, useEffect, useRef, useState } from "react";
+import { useElementSize } from "./useElementSize";
+
+type Props = {
+  channels: number[];
+  minTileWidth: number;
+  tileHeight: number;
+  gap?: number;
+  overscanRows?: number;
+  className?: string;
+  renderTile: (channel: number, index: number) => ReactNode;
+  // Index range [first, last) of the mounted tiles, including overscan rows.
+  onRangeChange?: (first: number, last: number) => void;
+};
+
+// Scrolling tile grid that only mounts the rows in view (plus `overscanRows` above and below), so the
+// DOM stays the same size whether there are 64 channels or several thousand.
+export function ChannelGrid({
+  channels,
+  minTileWidth,
+  tileHeight,
+  gap = 10,
+  overscanRows = 1,
+  className,
+  renderTile,
+  onRangeChange,
+}: Props) {
+  const scrollRef = useRef<HTMLDivElement>(null);
+  const size = useElementSize(scrollRef);
+  const [scrollTop, setScrollTop] = useState(0);
+  const frameRef = useRef(0);
+
+  useEffect(() => () => window.cancelAnimationFrame(frameRef.current), []);
+
+  const onScroll = () => {
+    window.cancelAnimationFrame(frameRef.current);
+    frameRef.current = window.requestAnimationFrame(() => {
+      setScrollTop(scrollRef.current?.scrollTop ?? 0);
+    });
+  };
+
+  const columns = Math.max(1, Math.floor((size.width + gap) / (minTileWidth + gap)));
+  const tileWidth = Math.max(1, (size.width - gap * (columns - 1)) / columns);
+  const rowHeight = tileHeight + gap;
+  const rows = Math.ceil(channels.length / columns);
+  const firstRow = Math.max(0, Math.floor(scrollTop / rowHeight) - overscanRows);
+  const lastRow = Math.min(rows, Math.ceil((scrollTop + size.height) / rowHeight) + overscanRows);
+  const first = Math.min(channels.length, firstRow * columns);
+  const last = Math.min(channels.length, lastRow * columns);
+
+  useEffect(() => {
+    onRangeChange?.(first, last);
+  }, [first, last, onRangeChange]);
+
+  const tiles: ReactNode[] = [];
+  for (let index = first; index < last; index += 1) {
+    const row = Math.floor(index / columns);
+    const column = index % columns;
+    tiles.push(
+      <div
+        key={channels[index]}
+        className="channel-grid-cell"
+        style={{
+          top: row * rowHeight,
+          left: column * (tileWidth + gap),
+          width: tileWidth,
+          height: tileHeight,
+        }}
+      >
+        {renderTile(channels[index], index)}
+      </div>
+    );
+  }
+
+  return (
+    <div ref={scrollRef} className={className ? `channel-grid ${className}` : "channel-grid"} onScroll={onScroll}>
+      <div className="channel-grid-inner" style={{ height: Math.max(0, rows * rowHeight - gap) }}>
+        {tiles}
+      </div>
+    </div>
+  );
+}
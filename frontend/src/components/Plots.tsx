@@ -279,3 +279,25 @@ export function LineSeries({
     </svg>
   );
 }
+
+// Overview tile spectrum: one <path> regardless of the bin count, with no axes, so a grid of
+// thumbnails stays cheap to mount and repaint.
+export function ThumbnailBars({ data, yMax }: { data: number[]; yMax?: number }) {
+  const max = Number.isFinite(yMax) && yMax! > 0 ? yMax! : Math.max(1, ...data);
+  const path = data
+    .map((value, index) => {
+      if (value <= 0) {
+        return "";
+      }
+      const top = 1 - Math.min(1, value / max);
+      return `M${index + 0.1} 1V${top.toFixed(3)}H${index + 0.9}V1Z`;
+    })
+    .join("");
+
+  return (
+    <svg className="thumbnail-bars" viewBox={`0 0 ${Math.max(1, data.length)} 1`} preserveAspectRatio="none">
+      <path d={path} className="plot-bar" />
+      <line x1={0} y1={1} x2={Math.max(1, data.length)} y2={1} className="plot-axis" vectorEffect="non-scaling-stroke" />
+    </svg>
+  );
+}
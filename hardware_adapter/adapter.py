@@ -5,18 +5,48 @@ from __future__ import annotations
 
 import argparse
 import json
+import queue
 import socket
 import struct
 import sys
+import threading
 import time
+import zlib
+from array import array
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Dict, Iterable, List, Optional, Tuple
+from typing import Callable, Dict, Iterable, List, Optional, Tuple
 
 SUBRECORD_SIZE = 12
 RECORD_SIZE = 24
 PPS_TICKS = 10_000_000
 
+# Edge pre-aggregation frame (see docs/02-Data-Contract.md, section C). Frames start with 0x1E,
+# which never starts an NDJSON line, so they can share a stream with sampled raw events.
+AGGREGATE_MARKER = 0x1E
+AGGREGATE_VERSION = 2
+HIST_BINS = 64
+# marker, magic, version, bins, t_start_us, t_end_us, events, channel entries
+AGGREGATE_HEADER = struct.Struct("<B3sBBqqIH")
+# channel, count, adc_x sum, adc_gtop sum, adc_gbot sum; followed by u32 adc_x[bins], adc_gtop[bins], adc_gbot[bins]
+AGGREGATE_CHANNEL = struct.Struct("<BIQQQ")
+
+# Framed deflate transport (docs/02-Data-Contract.md, section D), same as backend/src/stream_compression.py.
+COMPRESS_HELLO = b"QLHELLO"
+COMPRESS_HELLO_DEFLATE = b"compress=deflate"
+COMPRESS_MAGIC = b"QLZ1"
+COMPRESS_HELLO_WAIT_S = 0.2
+# compressed payload length, decoded length
+COMPRESS_FRAME_HEADER = struct.Struct("<II")
+COMPRESS_DICTIONARY = (
+    b'{"t_us":1700000000000123,"channel":3,"adc_x":1712,"adc_gtop":2540,"adc_gbot":2466,'
+    b'"flags":{"trg_x":true,"trg_g":true,"no_data":false,"is_g_event":true}}\n'
+    b'{"t_us":1700000000000000,"channel":12,"adc_x":2048,"adc_gtop":2311,"adc_gbot":1998,'
+    b'"flags":{"trg_x":false,"trg_g":false,"no_data":false,"is_g_event":false}}\n'
+)
+# Receivers name their dictionary in the hello; a different copy must not be used to compress.
+COMPRESS_DICTIONARY_ID = f"{zlib.crc32(COMPRESS_DICTIONARY):08x}".encode("ascii")
+
 
 @dataclass
 class DecoderState:
@@ -25,12 +55,26 @@ class DecoderState:
 
 
 class ChannelMapper:
-    def __init__(self, mapping_path: Optional[Path] = None) -> None:
+    def __init__(self, mapping_path: Optional[Path] = None, verbose: bool = True) -> None:
         self._raw_to_channel: Dict[int, int] = {}
         self._next_channel = 0
+        self.verbose = verbose
         if mapping_path:
             self._load_mapping(mapping_path)
 
+    @classmethod
+    def from_snapshot(cls, snapshot: dict, verbose: bool = True) -> "ChannelMapper":
+        mapper = cls(verbose=verbose)
+        mapper._raw_to_channel = {int(raw_id): int(channel) for raw_id, channel in snapshot["channels"].items()}
+        mapper._next_channel = int(snapshot["next_channel"])
+        return mapper
+
+    def snapshot(self) -> dict:
+        return {
+            "channels": {str(raw_id): channel for raw_id, channel in self._raw_to_channel.items()},
+            "next_channel": self._next_channel,
+        }
+
     def _load_mapping(self, mapping_path: Path) -> None:
         payload = json.loads(mapping_path.read_text(encoding="utf-8"))
         if not isinstance(payload, dict):
@@ -51,7 +95,8 @@ class ChannelMapper:
         channel = self._next_channel
         self._raw_to_channel[raw_id] = channel
         self._next_channel += 1
-        print(f"[adapter] auto-mapped raw_id={raw_id} -> channel={channel}", file=sys.stderr, flush=True)
+        if self.verbose:
+            print(f"[adapter] auto-mapped raw_id={raw_id} -> channel={channel}", file=sys.stderr, flush=True)
         return channel
 
     def describe(self) -> str:
@@ -61,11 +106,99 @@ class ChannelMapper:
         return ", ".join(f"{raw}:{ch}" for raw, ch in ordered)
 
 
+@dataclass
+class CompressionSettings:
+    level: int = 1
+    block_bytes: int = 16384
+    flush_s: float = 0.02
+
+
+class FrameCompressor:
+    """One connection's deflate stream: buffers output and ships it as QLZ1 frames."""
+
+    def __init__(self, settings: CompressionSettings) -> None:
+        self.settings = settings
+        self.deflate = zlib.compressobj(settings.level, zlib.DEFLATED, -15, zdict=COMPRESS_DICTIONARY)
+        self.pending: List[bytes] = []
+        self.pending_bytes = 0
+        self.last_frame_s = time.monotonic()
+        self.raw_bytes = 0
+        self.wire_bytes = 0
+        self.cpu_s = 0.0
+
+    def add(self, data: bytes) -> Optional[bytes]:
+        """Buffers data; returns a frame once a block is full or the oldest data is flush_s old."""
+        self.pending.append(data)
+        self.pending_bytes += len(data)
+        if self.pending_bytes >= self.settings.block_bytes or time.monotonic() - self.last_frame_s >= self.settings.flush_s:
+            return self.flush()
+        return None
+
+    def flush_if_due(self) -> Optional[bytes]:
+        """Ships buffered data that has waited flush_s with no further add() to push it out."""
+        if self.pending and time.monotonic() - self.last_frame_s >= self.settings.flush_s:
+            return self.flush()
+        return None
+
+    def flush(self) -> Optional[bytes]:
+        if not self.pending:
+            return None
+        raw = b"".join(self.pending)
+        self.pending.clear()
+        self.pending_bytes = 0
+        cpu_start = time.thread_time()
+        body = self.deflate.compress(raw) + self.deflate.flush(zlib.Z_SYNC_FLUSH)
+        self.cpu_s += time.thread_time() - cpu_start
+        self.last_frame_s = time.monotonic()
+        self.raw_bytes += len(raw)
+        self.wire_bytes += COMPRESS_FRAME_HEADER.size + len(body)
+        return COMPRESS_FRAME_HEADER.pack(len(body), len(raw)) + body
+
+
+def client_wants_compression(hello: bytes) -> bool:
+    """True for a `QLHELLO compress=deflate` line naming our dictionary, or naming none (older receivers)."""
+    if not hello.startswith(COMPRESS_HELLO) or COMPRESS_HELLO_DEFLATE not in hello:
+        return False
+    for token in hello.split():
+        if token.startswith(b"dict=") and token[5:] != COMPRESS_DICTIONARY_ID:
+            print(
+                f"[adapter] client dictionary {token[5:].decode('ascii', 'replace')} != {COMPRESS_DICTIONARY_ID.decode()}; "
+                "sending plain output",
+                file=sys.stderr,
+            )
+            return False
+    return True
+
+
+@dataclass
+class PendingClient:
+    """A server client still within COMPRESS_HELLO_WAIT_S of connecting, with the hello bytes so far."""
+
+    conn: socket.socket
+    addr: Tuple[str, int]
+    deadline_s: float
+    hello: bytes = b""
+
+
 class OutputFanout:
-    def __init__(self, emit_stdout: bool, tcp_server: Optional[Tuple[str, int]], tcp_client: Optional[Tuple[str, int]]) -> None:
+    def __init__(
+        self,
+        emit_stdout: bool,
+        tcp_server: Optional[Tuple[str, int]],
+        tcp_client: Optional[Tuple[str, int]],
+        compression: Optional[CompressionSettings] = None,
+    ) -> None:
         self.emit_stdout = emit_stdout
         self.server_socket: Optional[socket.socket] = None
         self.server_clients: List[socket.socket] = []
+        # With compression, new clients wait here for their hello without blocking emit().
+        self.pending_clients: List[PendingClient] = []
+        # Server clients that negotiated compression, and totals of the ones already gone.
+        self.compression = compression
+        self.compressors: Dict[socket.socket, FrameCompressor] = {}
+        self.compressed_raw_bytes = 0
+        self.compressed_wire_bytes = 0
+        self.compress_cpu_s = 0.0
         self.client_target = tcp_client
         self.client_socket: Optional[socket.socket] = None
         self.client_last_retry_s = 0.0
@@ -93,8 +226,50 @@ class OutputFanout:
             except BlockingIOError:
                 return
             conn.setblocking(False)
+            if self.compression:
+                self.pending_clients.append(PendingClient(conn, addr, time.monotonic() + COMPRESS_HELLO_WAIT_S))
+                continue
             self.server_clients.append(conn)
-            print(f"[adapter] TCP server client connected: {addr[0]}:{addr[1]}", file=sys.stderr)
+            print(f"[adapter] TCP server client connected: {addr[0]}:{addr[1]} (plain)", file=sys.stderr)
+
+    def _settle_pending_clients(self) -> None:
+        """Reads whatever hello bytes have arrived; a client joins once its line is complete or its wait ends.
+
+        Output emitted meanwhile is not sent to it, the same as if it had connected a moment later.
+        """
+        if not self.pending_clients:
+            return
+        now = time.monotonic()
+        waiting: List[PendingClient] = []
+        for pending in self.pending_clients:
+            closed = False
+            try:
+                data = pending.conn.recv(128 - len(pending.hello))
+                closed = not data
+                pending.hello += data
+            except BlockingIOError:
+                pass
+            except OSError:
+                closed = True
+            if closed:
+                pending.conn.close()
+                continue
+            if b"\n" not in pending.hello and len(pending.hello) < 128 and now < pending.deadline_s:
+                waiting.append(pending)
+                continue
+            conn, addr = pending.conn, pending.addr
+            mode = "plain"
+            if client_wants_compression(pending.hello):
+                try:
+                    conn.sendall(COMPRESS_MAGIC)
+                except OSError:
+                    conn.close()
+                    continue
+                self.compressors[conn] = FrameCompressor(self.compression)
+                mode = "deflate"
+            self.server_clients.append(conn)
+            print(f"[adapter] TCP server client connected: {addr[0]}:{addr[1]} ({mode})", file=sys.stderr)
+        self.pending_clients = waiting
 
     def _ensure_client_connected(self) -> None:
         if not self.client_target or self.client_socket:
@@ -114,6 +289,7 @@ class OutputFanout:
 
     def emit(self, line: bytes) -> None:
         self._accept_server_clients()
+        self._settle_pending_clients()
         self._ensure_client_connected()
 
         if self.emit_stdout:
@@ -123,11 +299,14 @@ class OutputFanout:
         if self.server_clients:
             keep: List[socket.socket] = []
             for conn in self.server_clients:
+                compressor = self.compressors.get(conn)
+                data = compressor.add(line) if compressor else line
                 try:
-                    conn.sendall(line)
+                    if data:
+                        conn.sendall(data)
                     keep.append(conn)
                 except OSError:
-                    conn.close()
+                    self._drop_client(conn)
             self.server_clients = keep
 
         if self.client_socket:
@@ -137,9 +316,50 @@ class OutputFanout:
                 self.client_socket.close()
                 self.client_socket = None
 
+    def flush_idle(self) -> None:
+        """Admits waiting clients and sends compressed output that is due while no new lines arrive."""
+        self._accept_server_clients()
+        self._settle_pending_clients()
+        if not self.compressors:
+            return
+        keep: List[socket.socket] = []
+        for conn in self.server_clients:
+            compressor = self.compressors.get(conn)
+            frame = compressor.flush_if_due() if compressor else None
+            try:
+                if frame:
+                    conn.sendall(frame)
+                keep.append(conn)
+            except OSError:
+                self._drop_client(conn)
+        self.server_clients = keep
+
+    def _drop_client(self, conn: socket.socket) -> None:
+        compressor = self.compressors.pop(conn, None)
+        if compressor:
+            self.compressed_raw_bytes += compressor.raw_bytes
+            self.compressed_wire_bytes += compressor.wire_bytes
+            self.compress_cpu_s += compressor.cpu_s
+        try:
+            # An unread compression hello would turn the close into a connection reset.
+            conn.recv(4096)
+        except OSError:
+            pass
+        conn.close()
+
     def close(self) -> None:
+        for pending in self.pending_clients:
+            pending.conn.close()
         for conn in self.server_clients:
-            conn.close()
+            compressor = self.compressors.get(conn)
+            frame = compressor.flush() if compressor else None
+            if frame:
+                try:
+                    conn.setblocking(True)
+                    conn.sendall(frame)
+                except OSError:
+                    pass
+            self._drop_client(conn)
         if self.server_socket:
             self.server_socket.close()
         if self.client_socket:
@@ -181,15 +401,25 @@ def unwrap_ticks(time_ticks: int, state: DecoderState, unwrap_threshold_ticks: i
     return candidate
 
 
-def iter_subrecords_from_binary(stream) -> Iterable[Tuple[int, int]]:
+def iter_subrecords_from_binary(
+    stream,
+    read_size: int = 4096,
+    on_block: Optional[Callable[[bytes], None]] = None,
+) -> Iterable[Tuple[int, int]]:
+    """Yields (raw_id, word); on_block sees each run of whole subrecords before any is yielded."""
     buffer = bytearray()
+    # read1 returns whatever has arrived instead of waiting for a full read_size, so the tail of a
+    # burst is decoded even if the source then goes quiet.
+    read = getattr(stream, "read1", stream.read)
     while True:
-        chunk = stream.read(4096)
+        chunk = read(read_size)
         if not chunk:
             break
         buffer.extend(chunk)
         whole = len(buffer) // SUBRECORD_SIZE
         upto = whole * SUBRECORD_SIZE
+        if on_block and upto:
+            on_block(bytes(buffer[:upto]))
         for offset in range(0, upto, SUBRECORD_SIZE):
             raw_id, word = struct.unpack_from("<IQ", buffer, offset)
             yield raw_id, word
@@ -220,14 +450,335 @@ def build_event(raw_id: int, word: int, mapper: ChannelMapper, state: DecoderSta
     return event
 
 
+def adc_to_bin(adc: int) -> int:
+    return min(HIST_BINS - 1, max(0, min(4095, adc)) // 64)
+
+
+class EdgeAggregator:
+    """Per-channel counts, ADC sums and 64-bin histograms over fixed slices of event time."""
+
+    def __init__(self, slice_us: int) -> None:
+        self.slice_us = slice_us
+        self.slice_index: Optional[int] = None
+        self.t_start_us = 0
+        self.t_end_us = 0
+        self.events = 0
+        self.counts = [0] * 64
+        self.hists = [array("I", bytes(4 * 64 * HIST_BINS)) for _ in range(3)]
+        # Exact ADC sums, so the backend's mean-ADC maps are not limited to bin centres.
+        self.adc_sums = [[0] * 64 for _ in range(3)]
+        self.frames = 0
+        self.idle_frames = 0
+        self.last_add_s = 0.0
+
+    def add(self, event: dict) -> Optional[bytes]:
+        """Adds one event; returns the finished frame when the event starts a new slice."""
+        t_us = event["t_us"]
+        frame = None
+        slice_index = t_us // self.slice_us
+        if self.slice_index is not None and slice_index != self.slice_index:
+            frame = self.flush()
+        if self.events == 0:
+            self.t_start_us = t_us
+            self.slice_index = slice_index
+        self.t_end_us = t_us
+        self.events += 1
+        self.last_add_s = time.monotonic()
+        channel = event["channel"]
+        self.counts[channel] += 1
+        base = channel * HIST_BINS
+        adc_x, adc_gtop, adc_gbot = event["adc_x"], event["adc_gtop"], event["adc_gbot"]
+        self.hists[0][base + adc_to_bin(adc_x)] += 1
+        self.hists[1][base + adc_to_bin(adc_gtop)] += 1
+        self.hists[2][base + adc_to_bin(adc_gbot)] += 1
+        self.adc_sums[0][channel] += adc_x
+        self.adc_sums[1][channel] += adc_gtop
+        self.adc_sums[2][channel] += adc_gbot
+        return frame
+
+    def flush_if_idle(self, idle_s: float) -> Optional[bytes]:
+        """Closes the open slice early once no event has arrived for idle_s of wall time.
+
+        A slice normally ends when the first event of the next one arrives, which never happens
+        while the source is quiet. Events that arrive later for the same slice go out as another
+        partial frame, which the backend merges like any other.
+        """
+        if self.events and time.monotonic() - self.last_add_s >= idle_s:
+            self.idle_frames += 1
+            return self.flush()
+        return None
+
+    def flush(self) -> Optional[bytes]:
+        if self.events == 0:
+            return None
+        touched = [channel for channel, count in enumerate(self.counts) if count]
+        parts = [
+            AGGREGATE_HEADER.pack(
+                AGGREGATE_MARKER,
+                b"QLA",
+                AGGREGATE_VERSION,
+                HIST_BINS,
+                self.t_start_us,
+                self.t_end_us,
+                self.events,
+                len(touched),
+            )
+        ]
+        for channel in touched:
+            parts.append(AGGREGATE_CHANNEL.pack(channel, self.counts[channel], *(sums[channel] for sums in self.adc_sums)))
+            for sums in self.adc_sums:
+                sums[channel] = 0
+            base = channel * HIST_BINS
+            for hist in self.hists:
+                values = hist[base : base + HIST_BINS]
+                if sys.byteorder == "big":
+                    values.byteswap()
+                parts.append(values.tobytes())
+                hist[base : base + HIST_BINS] = array("I", bytes(4 * HIST_BINS))
+            self.counts[channel] = 0
+        self.events = 0
+        self.slice_index = None
+        self.frames += 1
+        return b"".join(parts)
+
+
+class IdleFlusher:
+    """Background thread that ships held aggregate slices and compressed output while input is quiet.
+
+    The decode loop only flushes when the next event arrives, so a stalled source would otherwise
+    leave the last slice and the last compressed block sitting in the adapter. Every emit shares
+    `lock` with the decode loop because OutputFanout is not thread-safe.
+    """
+
+    def __init__(
+        self,
+        fanout: OutputFanout,
+        aggregator: Optional[EdgeAggregator],
+        lock: threading.Lock,
+        idle_s: float,
+    ) -> None:
+        self.fanout = fanout
+        self.aggregator = aggregator
+        self.lock = lock
+        self.idle_s = idle_s
+        self.stopped = threading.Event()
+        self.thread = threading.Thread(target=self._run, name="idle-flusher", daemon=True)
+        self.thread.start()
+
+    def close(self) -> None:
+        self.stopped.set()
+        self.thread.join()
+
+    def _run(self) -> None:
+        while not self.stopped.wait(max(0.005, self.idle_s / 2)):
+            with self.lock:
+                if self.aggregator:
+                    frame = self.aggregator.flush_if_idle(self.idle_s)
+                    if frame:
+                        self.fanout.emit(frame)
+                self.fanout.flush_idle()
+
+
+CAPTURE_FILE_PATTERN = "capture-{:06d}.qlraw"
+CAPTURE_INDEX_NAME = "capture-index.ndjson"
+CAPTURE_READ_SIZE = 1 << 20
+
+
+class CaptureWriter:
+    """Tees whole 12-byte subrecords to rotating capture files in a directory.
+
+    The decode thread only decides file names, offsets and index entries; the bytes go through a
+    queue to a writer thread that batches them into large writes. Each index line records where a
+    block starts and the decoder and channel-mapping state just before it, so any block can be
+    decoded again on its own (see iter_capture_events). Every writer starts a new session in a new
+    file, and its index lines carry that file's number as "session", because a restarted adapter
+    decodes from fresh state and may have been given a different mapping.
+    """
+
+    def __init__(self, directory: Path, rotate_bytes: int, index_every_records: int, buffer_bytes: int = 4 << 20) -> None:
+        directory.mkdir(parents=True, exist_ok=True)
+        self.directory = directory
+        self.rotate_bytes = max(SUBRECORD_SIZE, rotate_bytes)
+        self.index_every_records = max(1, index_every_records)
+        self.buffer_bytes = buffer_bytes
+        existing = sorted(directory.glob("capture-*.qlraw"))
+        self.file_number = len(existing)
+        self.session = self.file_number + 1
+        self.file_name = ""
+        self.file_offset = self.rotate_bytes
+        self.records = 0
+        self.records_since_index = self.index_every_records
+        self.bytes_written = 0
+        self.queue: "queue.Queue[Optional[Tuple[str, bytes]]]" = queue.Queue(maxsize=256)
+        self.thread = threading.Thread(target=self._run, name="capture-writer", daemon=True)
+        self.thread.start()
+
+    def write_block(self, block: bytes, state: DecoderState, mapper: ChannelMapper, unwrap_threshold_ticks: int) -> None:
+        """Queues a block of whole subrecords; state and mapper are as of just before the block."""
+        if self.file_offset + len(block) > self.rotate_bytes and self.file_offset > 0:
+            self.file_number += 1
+            self.file_name = CAPTURE_FILE_PATTERN.format(self.file_number)
+            self.file_offset = 0
+            self.records_since_index = self.index_every_records
+            self.queue.put(("open", self.file_name.encode("ascii")))
+        if self.records_since_index >= self.index_every_records:
+            self.records_since_index = 0
+            probe = DecoderState(state.last_unwrapped_ticks, state.wrap_offset_ticks)
+            _, first_word = struct.unpack_from("<IQ", block, 0)
+            first_ticks = unwrap_ticks((first_word >> 2) & 0xFFFFFF, probe, unwrap_threshold_ticks)
+            entry = {
+                "file": self.file_name,
+                "session": self.session,
+                "offset": self.file_offset,
+                "record": self.records,
+                "t_us": first_ticks // 10,
+                "last_unwrapped_ticks": state.last_unwrapped_ticks,
+                "wrap_offset_ticks": state.wrap_offset_ticks,
+                "unwrap_threshold_ticks": unwrap_threshold_ticks,
+                "mapping": mapper.snapshot(),
+            }
+            self.queue.put(("index", (json.dumps(entry, separators=(",", ":")) + "\n").encode("utf-8")))
+        self.queue.put(("data", block))
+        count = len(block) // SUBRECORD_SIZE
+        self.records += count
+        self.records_since_index += count
+        self.file_offset += len(block)
+        self.bytes_written += len(block)
+
+    def close(self) -> None:
+        self.queue.put(None)
+        self.thread.join()
+
+    def _run(self) -> None:
+        index_fp = open(self.directory / CAPTURE_INDEX_NAME, "ab")
+        data_fp = None
+        pending = bytearray()
+        try:
+            while True:
+                item = self.queue.get()
+                if item is None:
+                    break
+                kind, payload = item
+                if kind == "data":
+                    pending += payload
+                    if len(pending) >= self.buffer_bytes and data_fp:
+                        data_fp.write(pending)
+                        pending.clear()
+                elif kind == "open":
+                    if data_fp:
+                        data_fp.write(pending)
+                        pending.clear()
+                        data_fp.close()
+                    data_fp = open(self.directory / payload.decode("ascii"), "wb")
+                else:
+                    # Index lines only point at bytes already queued, so write the data first.
+                    if data_fp and pending:
+                        data_fp.write(pending)
+                        pending.clear()
+                        data_fp.flush()
+                    index_fp.write(payload)
+                    index_fp.flush()
+        finally:
+            if data_fp:
+                data_fp.write(pending)
+                data_fp.close()
+            index_fp.close()
+
+
+def load_capture_index(directory: Path) -> List[dict]:
+    entries = []
+    with open(directory / CAPTURE_INDEX_NAME, "r", encoding="utf-8") as index_fp:
+        for line in index_fp:
+            line = line.strip()
+            if line:
+                entries.append(json.loads(line))
+    return entries
+
+
+def iter_capture_events(
+    directory: Path,
+    t_start_us: Optional[int] = None,
+    t_end_us: Optional[int] = None,
+) -> Iterable[dict]:
+    """Decodes a capture directory to events (no_data included), optionally limited to a time range.
+
+    Decoding starts at the last index entry at or before t_start_us, with the decoder and mapping
+    state saved there, and restarts from the saved state again where a later session begins, so
+    the output matches what the adapter emitted live.
+    """
+    entries = load_capture_index(directory)
+    if not entries:
+        return
+    start = entries[0]
+    if t_start_us is not None:
+        for entry in entries:
+            if entry["t_us"] > t_start_us:
+                break
+            start = entry
+    first_entries: Dict[str, dict] = {}
+    for entry in entries:
+        first_entries.setdefault(entry["file"], entry)
+    files = [start["file"]] + sorted(name for name in first_entries if name > start["file"])
+    session = start.get("session")
+    offset = start["offset"]
+    for name in files:
+        entry = start if name == start["file"] else first_entries[name]
+        # Indexes written before sessions were marked start each session at record 0.
+        if entry is start or (entry.get("session") != session if "session" in entry else entry["record"] == 0):
+            session = entry.get("session")
+            state = DecoderState(entry["last_unwrapped_ticks"], entry["wrap_offset_ticks"])
+            mapper = ChannelMapper.from_snapshot(entry["mapping"], verbose=False)
+            threshold = entry["unwrap_threshold_ticks"]
+        with open(directory / name, "rb") as data_fp:
+            data_fp.seek(offset)
+            for raw_id, word in iter_subrecords_from_binary(data_fp, CAPTURE_READ_SIZE):
+                event = build_event(raw_id, word, mapper, state, threshold)
+                if event is None:
+                    continue
+                if t_start_us is not None and event["t_us"] < t_start_us:
+                    continue
+                if t_end_us is not None and event["t_us"] > t_end_us:
+                    return
+                yield event
+        offset = 0
+
+
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser(description="Hardware adapter: lab binary stream to Quicklook NDJSON")
-    parser.add_argument("--input", choices=["file", "stdin"], required=True)
+    parser.add_argument("--input", choices=["file", "stdin", "capture"], required=True)
     parser.add_argument("--file", type=Path, help="input file when --input file")
+    parser.add_argument(
+        "--capture-dir",
+        type=Path,
+        help="tee the raw binary stream to rotating capture files here; with --input capture, read them back",
+    )
+    parser.add_argument("--capture-rotate-mb", type=int, default=256, help="capture file size before rotating")
+    parser.add_argument(
+        "--capture-index-records",
+        type=int,
+        default=65536,
+        help="subrecords between capture index entries (smaller = finer time seeks)",
+    )
+    parser.add_argument("--t-start-us", type=int, help="with --input capture, first t_us to emit")
+    parser.add_argument("--t-end-us", type=int, help="with --input capture, last t_us to emit")
     parser.add_argument("--mapping", type=Path, help="optional raw_id->channel JSON mapping")
     parser.add_argument("--out", choices=["ndjson", "none"], default="ndjson", help="stdout output mode")
     parser.add_argument("--tcp-server", type=parse_host_port, help="serve NDJSON as TCP server host:port")
     parser.add_argument("--tcp-client", type=parse_host_port, help="push NDJSON to remote host:port")
+    parser.add_argument(
+        "--compress",
+        choices=["off", "deflate"],
+        default="off",
+        help="offer framed deflate to --tcp-server clients that ask for it (default: off)",
+    )
+    parser.add_argument("--compress-level", type=int, default=1, help="deflate level 0..9 (default: 1)")
+    parser.add_argument("--compress-block", type=int, default=16384, help="bytes per compressed frame (default: 16384)")
+    parser.add_argument(
+        "--compress-flush-ms",
+        type=int,
+        default=20,
+        help="longest time output waits for a full block, checked as events arrive (default: 20)",
+    )
     parser.add_argument(
         "--no-data",
         choices=["keep", "drop"],
@@ -244,6 +795,18 @@ def parse_args() -> argparse.Namespace:
         action="store_true",
         help="override policy and keep no_data events for debugging",
     )
+    parser.add_argument(
+        "--aggregate-ms",
+        type=int,
+        default=0,
+        help="ship binary per-channel partial aggregates every N ms of event time instead of raw events (0 = off)",
+    )
+    parser.add_argument(
+        "--sample-raw",
+        type=int,
+        default=0,
+        help="with --aggregate-ms, also pass every Nth event through as NDJSON marked \"sampled\" (0 = none)",
+    )
     parser.add_argument(
         "--unwrap-threshold-ticks",
         type=int,
@@ -266,14 +829,25 @@ def main() -> int:
     if args.input == "file" and not args.file:
         print("--file is required when --input file", file=sys.stderr)
         return 2
+    if args.input == "capture" and not args.capture_dir:
+        print("--capture-dir is required when --input capture", file=sys.stderr)
+        return 2
 
     mapper = ChannelMapper(mapping_path=args.mapping)
     print(f"[adapter] initial mapping: {mapper.describe()}", file=sys.stderr)
 
+    compression = None
+    if args.compress == "deflate":
+        compression = CompressionSettings(
+            level=max(0, min(9, args.compress_level)),
+            block_bytes=max(1024, min(32768, args.compress_block)),
+            flush_s=max(0, args.compress_flush_ms) / 1000.0,
+        )
     fanout = OutputFanout(
         emit_stdout=args.out == "ndjson",
         tcp_server=args.tcp_server,
         tcp_client=args.tcp_client,
+        compression=compression,
     )
 
     decode_state = DecoderState()
@@ -283,25 +857,84 @@ def main() -> int:
     dropped_no_channel = 0
     keep_no_data = keep_no_data_events(args)
     print(f"[adapter] no_data policy: {'keep' if keep_no_data else 'drop'}", file=sys.stderr)
-
-    try:
+    aggregator = EdgeAggregator(args.aggregate_ms * 1000) if args.aggregate_ms > 0 else None
+    sampled_raw = 0
+    if aggregator:
+        print(
+            f"[adapter] edge aggregation: {args.aggregate_ms} ms slices, raw sample 1/{args.sample_raw or 'none'}",
+            file=sys.stderr,
+        )
+
+    capture = None
+    if args.capture_dir and args.input != "capture":
+        capture = CaptureWriter(
+            args.capture_dir,
+            rotate_bytes=args.capture_rotate_mb * 1024 * 1024,
+            index_every_records=args.capture_index_records,
+        )
+        print(f"[adapter] raw capture: {args.capture_dir} (rotate {args.capture_rotate_mb} MB)", file=sys.stderr)
+
+    # A held slice goes out after one slice length of wall-clock silence, compressed output after
+    # its flush interval, whichever check comes first.
+    emit_lock = threading.Lock()
+    flusher = None
+    if aggregator or compression:
+        idle_times = []
+        if aggregator:
+            idle_times.append(args.aggregate_ms / 1000.0)
+        if compression and compression.flush_s > 0:
+            idle_times.append(compression.flush_s)
+        flusher = IdleFlusher(fanout, aggregator, emit_lock, min(idle_times, default=0.02))
+
+    def tee_block(block: bytes) -> None:
+        capture.write_block(block, decode_state, mapper, args.unwrap_threshold_ticks)
+
+    def iter_events() -> Iterable[Optional[dict]]:
+        if args.input == "capture":
+            yield from iter_capture_events(args.capture_dir, args.t_start_us, args.t_end_us)
+            return
         source = open(args.file, "rb") if args.input == "file" else sys.stdin.buffer
         with source if args.input == "file" else nullcontext(source):
-            for raw_id, word in iter_subrecords_from_binary(source):
-                event = build_event(raw_id, word, mapper, decode_state, args.unwrap_threshold_ticks)
-                if event is None:
-                    dropped_no_channel += 1
-                    continue
-                if event["flags"]["no_data"] and not keep_no_data:
-                    dropped_no_data += 1
-                    continue
-                line = (json.dumps(event, separators=(",", ":")) + "\n").encode("utf-8")
+            for raw_id, word in iter_subrecords_from_binary(source, on_block=tee_block if capture else None):
+                yield build_event(raw_id, word, mapper, decode_state, args.unwrap_threshold_ticks)
+
+    try:
+        for event in iter_events():
+            if event is None:
+                dropped_no_channel += 1
+                continue
+            if event["flags"]["no_data"] and not keep_no_data:
+                dropped_no_data += 1
+                continue
+            emitted_total += 1
+            if not event["flags"]["no_data"]:
+                emitted_hits += 1
+            if aggregator:
+                with emit_lock:
+                    frame = aggregator.add(event)
+                    if frame:
+                        fanout.emit(frame)
+                    if args.sample_raw > 0 and emitted_total % args.sample_raw == 0:
+                        event["sampled"] = True
+                        fanout.emit((json.dumps(event, separators=(",", ":")) + "\n").encode("utf-8"))
+                        sampled_raw += 1
+                continue
+            line = (json.dumps(event, separators=(",", ":")) + "\n").encode("utf-8")
+            with emit_lock:
                 fanout.emit(line)
-                emitted_total += 1
-                if not event["flags"]["no_data"]:
-                    emitted_hits += 1
+        if flusher:
+            flusher.close()
+            flusher = None
+        if aggregator:
+            frame = aggregator.flush()
+            if frame:
+                fanout.emit(frame)
     finally:
+        if flusher:
+            flusher.close()
         fanout.close()
+        if capture:
+            capture.close()
 
     print(
         "[adapter] done. "
@@ -311,6 +944,22 @@ def main() -> int:
         f"dropped_no_channel={dropped_no_channel}",
         file=sys.stderr,
     )
+    if aggregator:
+        print(
+            f"[adapter] aggregate_frames={aggregator.frames} idle_flushes={aggregator.idle_frames} sampled_raw={sampled_raw}",
+            file=sys.stderr,
+        )
+    if fanout.compressed_wire_bytes:
+        print(
+            "[adapter] compression: "
+            f"raw_bytes={fanout.compressed_raw_bytes} "
+            f"wire_bytes={fanout.compressed_wire_bytes} "
+            f"ratio={fanout.compressed_raw_bytes / fanout.compressed_wire_bytes:.2f} "
+            f"cpu_ms={fanout.compress_cpu_s * 1000:.1f}",
+            file=sys.stderr,
+        )
+    if capture:
+        print(f"[adapter] captured_bytes={capture.bytes_written} files={capture.file_number}", file=sys.stderr)
     print(f"[adapter] final mapping: {mapper.describe()}", file=sys.stderr)
     return 0
 
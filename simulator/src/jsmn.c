@@ -40,6 +40,9 @@ static int jsmn_parse_primitive(jsmn_parser *parser, const char *js, size_t len,
     }
     jsmn_fill_token(token, JSMN_PRIMITIVE, start, parser->pos);
     token->parent = parser->toksuper;
+    if (parser->toksuper != -1) {
+        tokens[parser->toksuper].size++;
+    }
     parser->pos--;
     return 0;
 }
@@ -58,6 +61,9 @@ static int jsmn_parse_string(jsmn_parser *parser, const char *js, size_t len,
             }
             jsmn_fill_token(token, JSMN_STRING, start + 1, parser->pos);
             token->parent = parser->toksuper;
+            if (parser->toksuper != -1) {
+                tokens[parser->toksuper].size++;
+            }
             return 0;
         }
         if (c == '\\' && parser->pos + 1 < len) {
@@ -84,6 +90,9 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *token
                 if (token == NULL) {
                     return -1;
                 }
+                if (parser->toksuper != -1) {
+                    tokens[parser->toksuper].size++;
+                }
                 token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
                 token->start = parser->pos;
                 token->parent = parser->toksuper;
@@ -111,12 +120,20 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *token
                     return -1;
                 }
                 break;
+            case ':':
+                parser->toksuper = (int)(parser->toknext - 1);
+                break;
+            case ',':
+                if (parser->toksuper != -1 &&
+                    tokens[parser->toksuper].type != JSMN_ARRAY &&
+                    tokens[parser->toksuper].type != JSMN_OBJECT) {
+                    parser->toksuper = tokens[parser->toksuper].parent;
+                }
+                break;
             case '\t':
             case '\r':
             case '\n':
             case ' ':
-            case ':':
-            case ',':
                 break;
             default:
                 if (jsmn_parse_primitive(parser, js, len, tokens, num_tokens) != 0) {
@@ -1,17 +1,30 @@
+#define _GNU_SOURCE
+
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <math.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include "jsmn.h"
+#include "probes.h"
 
 #define MAX_CHANNELS 64
 #define ADC_MAX 4095
@@ -22,6 +35,87 @@
 #define BURST_DURATION_S 3
 #define BURST_MULTIPLIER 3.5
 #define BURST_CHANNEL_FRACTION 0.25
+#define EVENT_MAX_LEN 256
+#define MAX_AMPLIFY_COPIES 64
+#define LAB_SUBRECORD_SIZE 12
+#define LAB_PPS_TICKS 10000000LL
+#define LAB_UNWRAP_THRESHOLD_TICKS 1000000LL
+#define JITTER_BUCKETS 4096
+#define INFLIGHT_SIZE 65536
+#define DEFAULT_QUEUE_BYTES (1024 * 1024)
+#define DEFAULT_OVERSIZE_BYTES 65536
+#define MAX_OVERSIZE_BYTES (16 * 1024 * 1024)
+#define MAX_MODULES 32
+#define POOL_T_US_OFFSET 8 /* strlen("{\"t_us\":") */
+#define POOL_T_US_WIDTH 16
+#define POOL_SLICE_EVENTS 4096
+#define MAX_POOL_EVENTS (16 * 1024 * 1024)
+#define COMPRESS_HELLO "QLHELLO"
+#define COMPRESS_HELLO_DEFLATE "compress=deflate"
+#define COMPRESS_HELLO_DICT "dict="
+#define COMPRESS_MAGIC "QLZ1"
+#define COMPRESS_HELLO_WAIT_MS 200
+#define COMPRESS_FRAME_HEADER 8
+#define DEFAULT_COMPRESS_BLOCK 16384
+#define MAX_COMPRESS_BLOCK 32768
+#define DEFAULT_COMPRESS_FLUSH_MS 20
+
+typedef enum {
+    PACING_SLEEP = 0,
+    PACING_BUSY = 1
+} PacingMode;
+
+typedef enum {
+    QUEUE_BLOCK = 0,
+    QUEUE_DROP_NEWEST = 1,
+    QUEUE_DROP_OLDEST = 2
+} QueuePolicy;
+
+typedef enum {
+    EVENT_FORMAT_NDJSON = 0,
+    EVENT_FORMAT_BINARY = 1
+} EventFormat;
+
+typedef enum {
+    FAULT_NONE = 0,
+    FAULT_TRUNCATE,
+    FAULT_CORRUPT,
+    FAULT_BAD_CHANNEL,
+    FAULT_TIME_REVERSE,
+    FAULT_OVERSIZE,
+    FAULT_SPLIT,
+    FAULT_KINDS
+} FaultKind;
+
+static const char *const fault_names[FAULT_KINDS] = {
+    "none", "truncate", "corrupt", "bad_channel", "time_reverse", "oversize", "split"
+};
+
+/* Per-event probabilities for each malformed-traffic kind; burst_len repeats a fault on following events. */
+typedef struct {
+    double prob[FAULT_KINDS];
+    bool enabled;
+    int oversize_bytes;
+    int burst_len;
+} FaultConfig;
+
+typedef struct {
+    long long t_us;
+    int channel;
+    int adc_x;
+    int adc_gtop;
+    int adc_gbot;
+    bool trg_x;
+    bool trg_g;
+    bool no_data;
+    bool is_g_event;
+} SimEvent;
+
+typedef struct {
+    SimEvent *events;
+    size_t count;
+    int channel_span;
+} Recording;
 
 typedef struct {
     int channel;
@@ -61,8 +155,55 @@ typedef struct {
     int stats_interval_s;
     const char *config_path;
     DistributionConfig dist;
+    const char *amplify_path;
+    EventFormat amplify_format;
+    int amplify_copies;
+    int amplify_channel_offset;
+    double amplify_speed;
+    int cpu;
+    int sched_fifo_prio;
+    bool mlock_all;
+    PacingMode pacing;
+    size_t queue_bytes;
+    QueuePolicy queue_policy;
+    FaultConfig faults;
+    int modules;
+    bool reuseport;
+    int channel_offset;
+    long long clock_offset_us;
+    long long module_clock_step_us;
+    int module_index;
+    size_t pool_events;
+    EventFormat pool_format;
+    bool compress;
+    int compress_level;
+    size_t compress_block;
+    int compress_flush_ms;
 } Config;
 
+/* Per-module overrides from the "modules" array of the JSON config; unset fields keep the shared value. */
+typedef struct {
+    int port;
+    int channels;
+    int channel_offset;
+    double rate_hz;
+    long long clock_offset_us;
+    unsigned int seed;
+    bool has_port;
+    bool has_channels;
+    bool has_channel_offset;
+    bool has_rate_hz;
+    bool has_clock_offset;
+    bool has_seed;
+    bool has_rate_multipliers;
+    bool has_dead_channels;
+    double rate_multipliers[MAX_CHANNELS];
+    bool dead_channels[MAX_CHANNELS];
+} ModuleOverride;
+
+static ModuleOverride module_overrides[MAX_MODULES];
+static int module_override_count = 0;
+
 static volatile sig_atomic_t stop_requested = 0;
 
 static void handle_signal(int sig) {
@@ -70,16 +211,40 @@ static void handle_signal(int sig) {
     stop_requested = 1;
 }
 
-static double uniform_rand(void) {
-    return (double)rand() / (double)RAND_MAX;
+/* "[mod N] " when several modules share stdout, empty otherwise. */
+static _Thread_local char log_tag[24] = "";
+
+static void log_printf(const char *fmt, ...) {
+    char line[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    flockfile(stdout);
+    fputs(log_tag, stdout);
+    fputs(line, stdout);
+    funlockfile(stdout);
+}
+
+/* Per-thread xorshift64* state so every module thread has its own reproducible stream. */
+static _Thread_local uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static void seed_rng(uint64_t seed) {
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+    if (rng_state == 0) {
+        rng_state = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+static uint32_t rng_u32(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
 }
 
-static double normal_rand(double mean, double stddev) {
-    double u1 = uniform_rand();
-    double u2 = uniform_rand();
-    double mag = sqrt(-2.0 * log(u1 + 1e-9));
-    double z0 = mag * cos(2.0 * M_PI * u2);
-    return mean + z0 * stddev;
+static double uniform_rand(void) {
+    return (double)rng_u32() / 4294967295.0;
 }
 
 static int clamp_adc(int value) {
@@ -123,6 +288,32 @@ static void init_config(Config *config) {
     config->stats_interval_s = 5;
     config->config_path = NULL;
     init_distribution(&config->dist);
+    config->amplify_path = NULL;
+    config->amplify_format = EVENT_FORMAT_NDJSON;
+    config->amplify_copies = 1;
+    config->amplify_channel_offset = 0;
+    config->amplify_speed = 1.0;
+    config->cpu = -1;
+    config->sched_fifo_prio = 0;
+    config->mlock_all = false;
+    config->pacing = PACING_SLEEP;
+    config->queue_bytes = DEFAULT_QUEUE_BYTES;
+    config->queue_policy = QUEUE_BLOCK;
+    memset(&config->faults, 0, sizeof(config->faults));
+    config->faults.oversize_bytes = DEFAULT_OVERSIZE_BYTES;
+    config->faults.burst_len = 1;
+    config->modules = 1;
+    config->reuseport = false;
+    config->channel_offset = 0;
+    config->clock_offset_us = 0;
+    config->module_clock_step_us = 0;
+    config->module_index = 0;
+    config->pool_events = 0;
+    config->pool_format = EVENT_FORMAT_NDJSON;
+    config->compress = false;
+    config->compress_level = 1;
+    config->compress_block = DEFAULT_COMPRESS_BLOCK;
+    config->compress_flush_ms = DEFAULT_COMPRESS_FLUSH_MS;
 }
 
 static const char *read_file(const char *path, size_t *out_len) {
@@ -270,6 +461,78 @@ static void apply_distribution_config(const char *json, jsmntok_t *tokens, int c
     }
 }
 
+static void read_json_bool_array(const char *json, jsmntok_t *tokens, int val_index, bool *out) {
+    memset(out, 0, sizeof(bool) * MAX_CHANNELS);
+    int arr_len = json_array_len(&tokens[val_index]);
+    for (int i = 0; i < arr_len; i++) {
+        int ch = json_token_to_int(json, &tokens[val_index + 1 + i]);
+        if (ch >= 0 && ch < MAX_CHANNELS) {
+            out[ch] = true;
+        }
+    }
+}
+
+static void read_json_double_array(const char *json, jsmntok_t *tokens, int val_index, double *out) {
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        out[i] = 1.0;
+    }
+    int arr_len = json_array_len(&tokens[val_index]);
+    for (int i = 0; i < arr_len && i < MAX_CHANNELS; i++) {
+        out[i] = json_token_to_double(json, &tokens[val_index + 1 + i]);
+    }
+}
+
+static void apply_module_configs(const char *json, jsmntok_t *tokens, int count, int arr_index) {
+    int arr_len = json_array_len(&tokens[arr_index]);
+    int idx = arr_index + 1;
+    module_override_count = 0;
+    for (int m = 0; m < arr_len && m < MAX_MODULES; m++) {
+        ModuleOverride *mod = &module_overrides[module_override_count++];
+        memset(mod, 0, sizeof(*mod));
+        int val_index = json_find_key(json, tokens, count, idx, "port");
+        if (val_index >= 0) {
+            mod->port = json_token_to_int(json, &tokens[val_index]);
+            mod->has_port = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "channels");
+        if (val_index >= 0) {
+            mod->channels = json_token_to_int(json, &tokens[val_index]);
+            mod->has_channels = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "channel_offset");
+        if (val_index >= 0) {
+            mod->channel_offset = json_token_to_int(json, &tokens[val_index]);
+            mod->has_channel_offset = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "rate_hz");
+        if (val_index >= 0) {
+            mod->rate_hz = json_token_to_double(json, &tokens[val_index]);
+            mod->has_rate_hz = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "clock_offset_us");
+        if (val_index >= 0) {
+            mod->clock_offset_us = (long long)json_token_to_double(json, &tokens[val_index]);
+            mod->has_clock_offset = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "seed");
+        if (val_index >= 0) {
+            mod->seed = (unsigned int)json_token_to_int(json, &tokens[val_index]);
+            mod->has_seed = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "rate_multipliers");
+        if (val_index >= 0 && tokens[val_index].type == JSMN_ARRAY) {
+            read_json_double_array(json, tokens, val_index, mod->rate_multipliers);
+            mod->has_rate_multipliers = true;
+        }
+        val_index = json_find_key(json, tokens, count, idx, "dead_channels");
+        if (val_index >= 0 && tokens[val_index].type == JSMN_ARRAY) {
+            read_json_bool_array(json, tokens, val_index, mod->dead_channels);
+            mod->has_dead_channels = true;
+        }
+        idx += json_token_span(tokens, idx);
+    }
+}
+
 static void apply_config_file(Config *config, const char *path) {
     size_t len = 0;
     const char *json = read_file(path, &len);
@@ -323,6 +586,10 @@ static void apply_config_file(Config *config, const char *path) {
     if (val_index >= 0) {
         apply_distribution_config(json, tokens, count, val_index, &config->dist);
     }
+    val_index = json_find_key(json, tokens, count, 0, "modules");
+    if (val_index >= 0 && tokens[val_index].type == JSMN_ARRAY) {
+        apply_module_configs(json, tokens, count, val_index);
+    }
 
     free((void *)json);
 }
@@ -357,6 +624,75 @@ static void parse_args(int argc, char **argv, Config *config) {
             config->drop_rate = atof(argv[++i]);
         } else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc) {
             config->stats_interval_s = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--amplify") == 0 && i + 1 < argc) {
+            config->amplify_path = argv[++i];
+        } else if (strcmp(argv[i], "--amplify-format") == 0 && i + 1 < argc) {
+            const char *format = argv[++i];
+            config->amplify_format = strcmp(format, "binary") == 0 ? EVENT_FORMAT_BINARY : EVENT_FORMAT_NDJSON;
+        } else if (strcmp(argv[i], "--amplify-copies") == 0 && i + 1 < argc) {
+            config->amplify_copies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--amplify-channel-offset") == 0 && i + 1 < argc) {
+            config->amplify_channel_offset = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--amplify-speed") == 0 && i + 1 < argc) {
+            config->amplify_speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            config->cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sched-fifo") == 0 && i + 1 < argc) {
+            config->sched_fifo_prio = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mlockall") == 0) {
+            config->mlock_all = true;
+        } else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            config->pacing = strcmp(mode, "busy") == 0 ? PACING_BUSY : PACING_SLEEP;
+        } else if (strcmp(argv[i], "--queue-bytes") == 0 && i + 1 < argc) {
+            long long bytes = atoll(argv[++i]);
+            config->queue_bytes = bytes > 0 ? (size_t)bytes : 0;
+        } else if (strcmp(argv[i], "--queue-policy") == 0 && i + 1 < argc) {
+            const char *policy = argv[++i];
+            if (strcmp(policy, "drop-newest") == 0) {
+                config->queue_policy = QUEUE_DROP_NEWEST;
+            } else if (strcmp(policy, "drop-oldest") == 0) {
+                config->queue_policy = QUEUE_DROP_OLDEST;
+            } else {
+                config->queue_policy = QUEUE_BLOCK;
+            }
+        } else if (strcmp(argv[i], "--fault-truncate") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_TRUNCATE] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-corrupt") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_CORRUPT] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-bad-channel") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_BAD_CHANNEL] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-time-reverse") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_TIME_REVERSE] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-oversize") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_OVERSIZE] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-oversize-bytes") == 0 && i + 1 < argc) {
+            config->faults.oversize_bytes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-split") == 0 && i + 1 < argc) {
+            config->faults.prob[FAULT_SPLIT] = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-burst") == 0 && i + 1 < argc) {
+            config->faults.burst_len = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--modules") == 0 && i + 1 < argc) {
+            config->modules = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reuseport") == 0) {
+            config->reuseport = true;
+        } else if (strcmp(argv[i], "--module-clock-step-us") == 0 && i + 1 < argc) {
+            config->module_clock_step_us = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--pool") == 0 && i + 1 < argc) {
+            long long events = atoll(argv[++i]);
+            config->pool_events = events > 0 ? (size_t)events : 0;
+        } else if (strcmp(argv[i], "--pool-format") == 0 && i + 1 < argc) {
+            const char *format = argv[++i];
+            config->pool_format = strcmp(format, "binary") == 0 ? EVENT_FORMAT_BINARY : EVENT_FORMAT_NDJSON;
+        } else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+            config->compress = strcmp(argv[++i], "deflate") == 0;
+        } else if (strcmp(argv[i], "--compress-level") == 0 && i + 1 < argc) {
+            config->compress_level = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compress-block") == 0 && i + 1 < argc) {
+            long long bytes = atoll(argv[++i]);
+            config->compress_block = bytes > 0 ? (size_t)bytes : 0;
+        } else if (strcmp(argv[i], "--compress-flush-ms") == 0 && i + 1 < argc) {
+            config->compress_flush_ms = atoi(argv[++i]);
         }
     }
 
@@ -365,6 +701,47 @@ static void parse_args(int argc, char **argv, Config *config) {
     if (config->drop_rate < 0.0) config->drop_rate = 0.0;
     if (config->drop_rate > 1.0) config->drop_rate = 1.0;
     if (config->stats_interval_s < 1) config->stats_interval_s = 1;
+    if (config->amplify_copies < 1) config->amplify_copies = 1;
+    if (config->amplify_copies > MAX_AMPLIFY_COPIES) config->amplify_copies = MAX_AMPLIFY_COPIES;
+    if (config->amplify_channel_offset < 0) config->amplify_channel_offset = 0;
+    if (config->amplify_speed <= 0.0) config->amplify_speed = 1.0;
+    if (config->queue_bytes < 4 * EVENT_MAX_LEN) config->queue_bytes = 4 * EVENT_MAX_LEN;
+    config->faults.enabled = false;
+    for (int k = FAULT_NONE + 1; k < FAULT_KINDS; k++) {
+        if (config->faults.prob[k] < 0.0) config->faults.prob[k] = 0.0;
+        if (config->faults.prob[k] > 1.0) config->faults.prob[k] = 1.0;
+        if (config->faults.prob[k] > 0.0) config->faults.enabled = true;
+    }
+    if (config->faults.oversize_bytes < EVENT_MAX_LEN) config->faults.oversize_bytes = EVENT_MAX_LEN;
+    if (config->faults.oversize_bytes > MAX_OVERSIZE_BYTES) config->faults.oversize_bytes = MAX_OVERSIZE_BYTES;
+    if ((size_t)config->faults.oversize_bytes * 2 > config->queue_bytes) {
+        config->queue_bytes = (size_t)config->faults.oversize_bytes * 2;
+    }
+    if (config->faults.burst_len < 1) config->faults.burst_len = 1;
+    if (module_override_count > config->modules) config->modules = module_override_count;
+    if (config->modules < 1) config->modules = 1;
+    if (config->modules > MAX_MODULES) config->modules = MAX_MODULES;
+    if (config->amplify_path && config->modules > 1) {
+        fprintf(stderr, "--amplify uses --amplify-copies; ignoring --modules %d\n", config->modules);
+        config->modules = 1;
+    }
+    if (config->pool_events > MAX_POOL_EVENTS) config->pool_events = MAX_POOL_EVENTS;
+    if (config->compress_level < 0) config->compress_level = 0;
+    if (config->compress_level > 9) config->compress_level = 9;
+    if (config->compress_block < 1024) config->compress_block = 1024;
+    if (config->compress_block > MAX_COMPRESS_BLOCK) config->compress_block = MAX_COMPRESS_BLOCK;
+    if (config->compress_flush_ms < 0) config->compress_flush_ms = 0;
+    if (config->pool_events > 0) {
+        if (config->amplify_path) {
+            fprintf(stderr, "--pool ignored with --amplify\n");
+            config->pool_events = 0;
+        } else if (config->faults.enabled || config->drop_rate > 0.0 || config->burst_mode) {
+            fprintf(stderr, "--pool sends the pool as rendered; ignoring fault, drop-rate and burst options\n");
+            config->faults.enabled = false;
+            config->drop_rate = 0.0;
+            config->burst_mode = false;
+        }
+    }
 }
 
 static void init_channel_weights(ChannelWeight *weights, Config *config) {
@@ -380,7 +757,7 @@ static void init_channel_weights(ChannelWeight *weights, Config *config) {
     }
 }
 
-static double compute_total_weight(ChannelWeight *weights, int channels, bool *burst_channels, bool burst_active) {
+static double compute_total_weight(const ChannelWeight *weights, int channels, const bool *burst_channels, bool burst_active) {
     double total = 0.0;
     for (int i = 0; i < channels; i++) {
         double weight = weights[i].weight;
@@ -392,50 +769,368 @@ static double compute_total_weight(ChannelWeight *weights, int channels, bool *b
     return total;
 }
 
-static int pick_channel(ChannelWeight *weights, int channels, double total_weight, bool *burst_channels, bool burst_active) {
-    double r = uniform_rand() * total_weight;
-    double accum = 0.0;
-    for (int i = 0; i < channels; i++) {
+/*
+ * Batch event synthesis. Events are generated EVENT_BATCH at a time in structure-of-arrays form:
+ * every random draw fills its own row of uniforms from RNG_LANES independent xorshift64* lanes,
+ * Gaussians come from an interpolated inverse-CDF table, and the per-event choices (g/x event,
+ * low-noise override, no_data, clamping) are branch-free selects, so the compiler can vectorize
+ * the kernel and no libm call sits on the per-event path.
+ */
+#define EVENT_BATCH 1024
+#define RNG_LANES 8 /* two u32x4 vectors in rng_fill */
+#define NORMAL_TABLE_BITS 12
+#define NORMAL_TABLE_SIZE (1 << NORMAL_TABLE_BITS)
+#define NORMAL_FRAC_BITS (32 - NORMAL_TABLE_BITS)
+
+#define EVENT_FLAG_TRG_X 0x01
+#define EVENT_FLAG_TRG_G 0x02
+#define EVENT_FLAG_NO_DATA 0x04
+#define EVENT_FLAG_G_EVENT 0x08
+
+enum {
+    DRAW_CHANNEL,
+    DRAW_CHANNEL_ALIAS,
+    DRAW_G_EVENT,
+    DRAW_TRG_X,
+    DRAW_TRG_G,
+    DRAW_NO_DATA,
+    DRAW_LOW_X,
+    DRAW_LOW_GTOP,
+    DRAW_LOW_GBOT,
+    /* Gaussian draws last; batch->normals holds them converted, in the same order. */
+    DRAW_ADC_X,
+    DRAW_ADC_GTOP,
+    DRAW_ADC_GBOT,
+    DRAW_LOW_X_ADC,
+    DRAW_LOW_GTOP_ADC,
+    DRAW_LOW_GBOT_ADC,
+    BATCH_DRAWS
+};
+
+#define FIRST_NORMAL_DRAW DRAW_ADC_X
+#define BATCH_NORMALS (BATCH_DRAWS - FIRST_NORMAL_DRAW)
+
+/* Standard-normal quantiles at (i + 0.5) / (NORMAL_TABLE_SIZE + 1); read-only once main() fills it. */
+static float normal_table[NORMAL_TABLE_SIZE + 1];
+
+static void init_normal_table(void) {
+    for (int i = 0; i <= NORMAL_TABLE_SIZE; i++) {
+        double p = (i + 0.5) / (NORMAL_TABLE_SIZE + 1.0);
+        double lo = -8.0;
+        double hi = 8.0;
+        for (int iter = 0; iter < 60; iter++) {
+            double mid = 0.5 * (lo + hi);
+            if (0.5 * erfc(-mid / M_SQRT2) < p) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        normal_table[i] = (float)(0.5 * (lo + hi));
+    }
+}
+
+typedef uint32_t u32x4 __attribute__((vector_size(16)));
+typedef int32_t i32x4 __attribute__((vector_size(16)));
+typedef float f32x4 __attribute__((vector_size(16)));
+
+/* RNG_LANES independent xoshiro128++ streams, four per vector, so rng_fill runs on SIMD registers. */
+typedef struct {
+    u32x4 s[4][RNG_LANES / 4];
+} LaneRng;
+
+typedef struct {
+    LaneRng rng;
+    /* Walker alias table over local channels; rebuilt whenever the burst set changes. */
+    uint32_t alias_threshold[MAX_CHANNELS];
+    int32_t alias[MAX_CHANNELS];
+    int channels;
+    uint32_t draws[BATCH_DRAWS][EVENT_BATCH];
+    float normals[BATCH_NORMALS][EVENT_BATCH];
+    int32_t channel[EVENT_BATCH];
+    int32_t adc_x[EVENT_BATCH];
+    int32_t adc_gtop[EVENT_BATCH];
+    int32_t adc_gbot[EVENT_BATCH];
+    uint8_t flags[EVENT_BATCH];
+    int count;
+    int next;
+} EventBatch;
+
+static void init_event_batch(EventBatch *batch, int channels) {
+    for (int v = 0; v < RNG_LANES / 4; v++) {
+        for (int k = 0; k < 4; k++) {
+            batch->rng.s[k][v] = (u32x4){rng_u32(), rng_u32(), rng_u32(), rng_u32()};
+        }
+        batch->rng.s[0][v] |= 1u;
+    }
+    batch->channels = channels;
+    batch->count = 0;
+    batch->next = 0;
+}
+
+/* Threshold t such that `u < t` holds with probability p for a uniform u32. */
+static uint32_t prob_threshold(double p) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return UINT32_MAX;
+    return (uint32_t)(p * 4294967296.0);
+}
+
+static void build_channel_alias(EventBatch *batch, const ChannelWeight *weights, const bool *burst_channels, bool burst_active) {
+    int n = batch->channels;
+    double scaled[MAX_CHANNELS];
+    int small[MAX_CHANNELS];
+    int large[MAX_CHANNELS];
+    int small_count = 0;
+    int large_count = 0;
+    double total = compute_total_weight(weights, n, burst_channels, burst_active);
+    for (int i = 0; i < n; i++) {
         double weight = weights[i].weight;
         if (burst_active && burst_channels[i]) {
             weight *= BURST_MULTIPLIER;
         }
-        accum += weight;
-        if (r <= accum) {
-            return weights[i].channel;
+        scaled[i] = total > 0.0 ? weight * n / total : (i == 0 ? (double)n : 0.0);
+        batch->alias[i] = weights[i].channel;
+        if (scaled[i] < 1.0) {
+            small[small_count++] = i;
+        } else {
+            large[large_count++] = i;
+        }
+    }
+    while (small_count > 0 && large_count > 0) {
+        int s = small[--small_count];
+        int l = large[large_count - 1];
+        batch->alias_threshold[s] = prob_threshold(scaled[s]);
+        batch->alias[s] = weights[l].channel;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large_count--;
+            small[small_count++] = l;
+        }
+    }
+    /* Leftovers are 1.0 up to rounding error. */
+    while (large_count > 0) {
+        batch->alias_threshold[large[--large_count]] = UINT32_MAX;
+    }
+    while (small_count > 0) {
+        batch->alias_threshold[small[--small_count]] = UINT32_MAX;
+    }
+}
+
+static inline u32x4 rotl_u32x4(u32x4 x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+static void rng_fill(LaneRng *restrict rng, uint32_t *restrict out, int count) {
+    u32x4 a0 = rng->s[0][0], a1 = rng->s[1][0], a2 = rng->s[2][0], a3 = rng->s[3][0];
+    u32x4 b0 = rng->s[0][1], b1 = rng->s[1][1], b2 = rng->s[2][1], b3 = rng->s[3][1];
+    for (int i = 0; i < count; i += RNG_LANES) {
+        u32x4 ra = rotl_u32x4(a0 + a3, 7) + a0;
+        u32x4 rb = rotl_u32x4(b0 + b3, 7) + b0;
+        memcpy(out + i, &ra, sizeof(ra));
+        memcpy(out + i + 4, &rb, sizeof(rb));
+        u32x4 ta = a1 << 9;
+        u32x4 tb = b1 << 9;
+        a2 ^= a0;
+        b2 ^= b0;
+        a3 ^= a1;
+        b3 ^= b1;
+        a1 ^= a2;
+        b1 ^= b2;
+        a0 ^= a3;
+        b0 ^= b3;
+        a2 ^= ta;
+        b2 ^= tb;
+        a3 = rotl_u32x4(a3, 11);
+        b3 = rotl_u32x4(b3, 11);
+    }
+    rng->s[0][0] = a0;
+    rng->s[1][0] = a1;
+    rng->s[2][0] = a2;
+    rng->s[3][0] = a3;
+    rng->s[0][1] = b0;
+    rng->s[1][1] = b1;
+    rng->s[2][1] = b2;
+    rng->s[3][1] = b3;
+}
+
+static inline float normal_from_u32(uint32_t u) {
+    uint32_t index = u >> NORMAL_FRAC_BITS;
+    float frac = (float)(u & ((1u << NORMAL_FRAC_BITS) - 1u)) * (1.0f / (float)(1u << NORMAL_FRAC_BITS));
+    float lo = normal_table[index];
+    return lo + frac * (normal_table[index + 1] - lo);
+}
+
+static inline u32x4 load_u32x4(const uint32_t *p) {
+    u32x4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline f32x4 load_f32x4(const float *p) {
+    f32x4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store_i32x4(int32_t *p, i32x4 v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline f32x4 splat_f32x4(float value) {
+    return (f32x4){value, value, value, value};
+}
+
+static inline f32x4 select_f32x4(i32x4 mask, f32x4 a, f32x4 b) {
+    return (f32x4)(((i32x4)a & mask) | ((i32x4)b & ~mask));
+}
+
+/* Round half up, then clamp to 0..ADC_MAX with integer compare/select (SSE2 has no pminsd). */
+static inline i32x4 round_clamp_adc_x4(f32x4 value) {
+    i32x4 adc = __builtin_convertvector(value + 0.5f, i32x4);
+    adc &= adc >= 0;
+    i32x4 over = adc > ADC_MAX;
+    return (adc & ~over) | (ADC_MAX & over);
+}
+
+static void fill_event_batch(EventBatch *restrict batch, const DistributionConfig *dist, int count) {
+    int padded = (count + RNG_LANES - 1) / RNG_LANES * RNG_LANES;
+    for (int d = 0; d < BATCH_DRAWS; d++) {
+        rng_fill(&batch->rng, batch->draws[d], padded);
+    }
+    for (int d = 0; d < BATCH_NORMALS; d++) {
+        const uint32_t *restrict u = batch->draws[FIRST_NORMAL_DRAW + d];
+        float *restrict z = batch->normals[d];
+        for (int i = 0; i < padded; i++) {
+            z[i] = normal_from_u32(u[i]);
+        }
+    }
+
+    const uint32_t *restrict u_channel = batch->draws[DRAW_CHANNEL];
+    const uint32_t *restrict u_alias = batch->draws[DRAW_CHANNEL_ALIAS];
+    const uint64_t channels = (uint64_t)batch->channels;
+    for (int i = 0; i < count; i++) {
+        uint32_t slot = (uint32_t)(((uint64_t)u_channel[i] * channels) >> 32);
+        batch->channel[i] = u_alias[i] < batch->alias_threshold[slot] ? (int32_t)slot : batch->alias[slot];
+    }
+
+    const uint32_t g_threshold = prob_threshold(dist->g_event_prob);
+    const uint32_t trg_x_threshold = prob_threshold(dist->trg_x_prob);
+    const uint32_t trg_g_threshold = prob_threshold(dist->trg_g_prob);
+    const uint32_t no_data_threshold = prob_threshold(dist->no_data_prob);
+    const uint32_t low_threshold = prob_threshold(dist->low_prob);
+    const f32x4 g_mean = splat_f32x4((float)dist->g_mean);
+    const f32x4 g_std = splat_f32x4((float)dist->g_std);
+    const f32x4 x_mean = splat_f32x4((float)dist->x_mean);
+    const f32x4 x_std = splat_f32x4((float)dist->x_std);
+    const float gtop_offset = (float)dist->gtop_offset;
+    const float gbot_offset = (float)dist->gbot_offset;
+    const float gtop_std_offset = (float)dist->gtop_std_offset;
+    const float gbot_std_offset = (float)dist->gbot_std_offset;
+    const float low_mean = (float)dist->low_mean;
+    const float low_std = (float)dist->low_std;
+    const uint32_t *restrict u_g = batch->draws[DRAW_G_EVENT];
+    const uint32_t *restrict u_trg_x = batch->draws[DRAW_TRG_X];
+    const uint32_t *restrict u_trg_g = batch->draws[DRAW_TRG_G];
+    const uint32_t *restrict u_no_data = batch->draws[DRAW_NO_DATA];
+    const uint32_t *restrict u_low_x = batch->draws[DRAW_LOW_X];
+    const uint32_t *restrict u_low_gtop = batch->draws[DRAW_LOW_GTOP];
+    const uint32_t *restrict u_low_gbot = batch->draws[DRAW_LOW_GBOT];
+    const float *restrict z_x = batch->normals[DRAW_ADC_X - FIRST_NORMAL_DRAW];
+    const float *restrict z_gtop = batch->normals[DRAW_ADC_GTOP - FIRST_NORMAL_DRAW];
+    const float *restrict z_gbot = batch->normals[DRAW_ADC_GBOT - FIRST_NORMAL_DRAW];
+    const float *restrict z_low_x = batch->normals[DRAW_LOW_X_ADC - FIRST_NORMAL_DRAW];
+    const float *restrict z_low_gtop = batch->normals[DRAW_LOW_GTOP_ADC - FIRST_NORMAL_DRAW];
+    const float *restrict z_low_gbot = batch->normals[DRAW_LOW_GBOT_ADC - FIRST_NORMAL_DRAW];
+    int32_t *restrict adc_x = batch->adc_x;
+    int32_t *restrict adc_gtop = batch->adc_gtop;
+    int32_t *restrict adc_gbot = batch->adc_gbot;
+    uint8_t *restrict flags = batch->flags;
+
+    for (int i = 0; i < padded; i += 4) {
+        i32x4 g_event = load_u32x4(u_g + i) < g_threshold;
+        i32x4 keep = load_u32x4(u_no_data + i) >= no_data_threshold;
+        i32x4 event_flags = ((load_u32x4(u_trg_x + i) < trg_x_threshold) & EVENT_FLAG_TRG_X)
+            | ((load_u32x4(u_trg_g + i) < trg_g_threshold) & EVENT_FLAG_TRG_G)
+            | (~keep & EVENT_FLAG_NO_DATA)
+            | (g_event & EVENT_FLAG_G_EVENT);
+        for (int k = 0; k < 4; k++) {
+            flags[i + k] = (uint8_t)event_flags[k];
         }
+
+        f32x4 mean = select_f32x4(g_event, g_mean, x_mean);
+        f32x4 std = select_f32x4(g_event, g_std, x_std);
+        f32x4 x = mean + load_f32x4(z_x + i) * std;
+        f32x4 gtop = mean + gtop_offset + load_f32x4(z_gtop + i) * (std + gtop_std_offset);
+        f32x4 gbot = mean + gbot_offset + load_f32x4(z_gbot + i) * (std + gbot_std_offset);
+        x = select_f32x4(load_u32x4(u_low_x + i) < low_threshold,
+            low_mean + load_f32x4(z_low_x + i) * low_std, x);
+        gtop = select_f32x4(load_u32x4(u_low_gtop + i) < low_threshold,
+            low_mean + 50.0f + load_f32x4(z_low_gtop + i) * (low_std + 10.0f), gtop);
+        gbot = select_f32x4(load_u32x4(u_low_gbot + i) < low_threshold,
+            low_mean - 20.0f + load_f32x4(z_low_gbot + i) * (low_std - 10.0f), gbot);
+
+        store_i32x4(adc_x + i, round_clamp_adc_x4(x) & keep);
+        store_i32x4(adc_gtop + i, round_clamp_adc_x4(gtop) & keep);
+        store_i32x4(adc_gbot + i, round_clamp_adc_x4(gbot) & keep);
     }
-    return weights[channels - 1].channel;
+    batch->count = count;
+    batch->next = 0;
+}
+
+/* Local channel of the next batched event; fills everything but t_us and the channel offset. */
+static int next_batch_event(EventBatch *batch, SimEvent *ev) {
+    int i = batch->next++;
+    uint8_t flags = batch->flags[i];
+    ev->channel = batch->channel[i];
+    ev->adc_x = batch->adc_x[i];
+    ev->adc_gtop = batch->adc_gtop[i];
+    ev->adc_gbot = batch->adc_gbot[i];
+    ev->trg_x = (flags & EVENT_FLAG_TRG_X) != 0;
+    ev->trg_g = (flags & EVENT_FLAG_TRG_G) != 0;
+    ev->no_data = (flags & EVENT_FLAG_NO_DATA) != 0;
+    ev->is_g_event = (flags & EVENT_FLAG_G_EVENT) != 0;
+    return ev->channel;
+}
+
+/* Batch size covering roughly 10 ms of events, so bursts still switch on time at low rates. */
+static int batch_size_for_rate(double rate_hz) {
+    double size = rate_hz / 100.0;
+    if (size < 1.0) return 1;
+    if (size > EVENT_BATCH) return EVENT_BATCH;
+    return (int)size;
 }
 
-static int setup_server(const char *host, int port) {
+static int setup_server(const char *host, int port, bool reuseport) {
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
-        perror("socket");
+        log_printf("socket: %s\n", strerror(errno));
         exit(1);
     }
 
     int opt = 1;
     setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        log_printf("setsockopt SO_REUSEPORT: %s\n", strerror(errno));
+    }
 
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_port = htons((uint16_t)port);
     if (inet_pton(AF_INET, host, &addr.sin_addr) <= 0) {
-        perror("inet_pton");
+        log_printf("inet_pton: %s\n", strerror(errno));
         close(server_fd);
         exit(1);
     }
 
     if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        perror("bind");
+        log_printf("bind: %s\n", strerror(errno));
         close(server_fd);
         exit(1);
     }
 
     if (listen(server_fd, 1) < 0) {
-        perror("listen");
+        log_printf("listen: %s\n", strerror(errno));
         close(server_fd);
         exit(1);
     }
@@ -449,53 +1144,822 @@ static long long now_us(void) {
     return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000LL;
 }
 
-static void log_rates(ChannelWeight *weights, int channels, double total_weight, double rate_hz) {
-    printf("Effective per-channel rates (Hz):\n");
+static long long clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* Lateness of each pacing wakeup, in 1 us buckets; the last bucket collects everything slower. */
+typedef struct {
+    unsigned long long buckets[JITTER_BUCKETS];
+    unsigned long long samples;
+    long long max_ns;
+} JitterStats;
+
+/*
+ * Schedule shared by all modules: one pacing clock and one epoch, fixed in main before the module
+ * threads start. Modules pace their events on slots counted from this epoch, so modules with the
+ * same rate stay in phase and a module whose client connects late joins the running schedule.
+ */
+typedef struct {
+    clockid_t clock;
+    long long epoch_ns;
+} Timeline;
+
+static void init_timeline(Timeline *timeline, PacingMode mode) {
+    timeline->clock = mode == PACING_BUSY ? CLOCK_MONOTONIC_RAW : CLOCK_MONOTONIC;
+    timeline->epoch_ns = clock_ns(timeline->clock);
+}
+
+typedef struct {
+    PacingMode mode;
+    const Timeline *timeline;
+    JitterStats jitter;
+} Pacer;
+
+static void init_pacer(Pacer *pacer, PacingMode mode, const Timeline *timeline) {
+    pacer->mode = mode;
+    pacer->timeline = timeline;
+    memset(&pacer->jitter, 0, sizeof(pacer->jitter));
+}
+
+static long long pacer_now_ns(const Pacer *pacer) {
+    return clock_ns(pacer->timeline->clock);
+}
+
+/* Index of the first timeline slot at or after now, for events every interval_ns. */
+static unsigned long long pacer_first_slot(const Pacer *pacer, double interval_ns) {
+    long long elapsed_ns = pacer_now_ns(pacer) - pacer->timeline->epoch_ns;
+    return elapsed_ns > 0 ? (unsigned long long)ceil((double)elapsed_ns / interval_ns) : 0;
+}
+
+/*
+ * Waits until deadline_ns on the pacer clock and records how late the wakeup was. Sleep mode uses
+ * an absolute clock_nanosleep; busy mode spins on CLOCK_MONOTONIC_RAW, trading a core for
+ * sub-microsecond wakeups.
+ */
+static void pacer_wait_until(Pacer *pacer, long long deadline_ns) {
+    long long now = pacer_now_ns(pacer);
+    if (now < deadline_ns) {
+        if (pacer->mode == PACING_BUSY) {
+            while (now < deadline_ns && !stop_requested) {
+                cpu_relax();
+                now = pacer_now_ns(pacer);
+            }
+        } else {
+            struct timespec req;
+            req.tv_sec = (time_t)(deadline_ns / 1000000000LL);
+            req.tv_nsec = (long)(deadline_ns % 1000000000LL);
+            clock_nanosleep(pacer->timeline->clock, TIMER_ABSTIME, &req, NULL);
+            now = pacer_now_ns(pacer);
+        }
+    }
+    long long late_ns = now - deadline_ns;
+    if (late_ns < 0) {
+        late_ns = 0;
+    }
+    long long bucket = late_ns / 1000;
+    if (bucket >= JITTER_BUCKETS) {
+        bucket = JITTER_BUCKETS - 1;
+    }
+    pacer->jitter.buckets[bucket]++;
+    pacer->jitter.samples++;
+    if (late_ns > pacer->jitter.max_ns) {
+        pacer->jitter.max_ns = late_ns;
+    }
+}
+
+static long long jitter_percentile_us(const JitterStats *jitter, double fraction) {
+    if (jitter->samples == 0) {
+        return 0;
+    }
+    unsigned long long target = (unsigned long long)ceil(fraction * (double)jitter->samples);
+    unsigned long long seen = 0;
+    for (int i = 0; i < JITTER_BUCKETS; i++) {
+        seen += jitter->buckets[i];
+        if (seen >= target) {
+            return i;
+        }
+    }
+    return JITTER_BUCKETS - 1;
+}
+
+/* Applies --cpu and --sched-fifo to the calling thread. Failures are reported but not fatal. */
+static void apply_thread_settings(const Config *config) {
+    if (config->cpu >= 0) {
+        int cpu = config->cpu + config->module_index;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            log_printf("pthread_setaffinity_np: failed to pin to CPU %d: %s\n", cpu, strerror(rc));
+        } else {
+            log_printf("Pinned to CPU %d\n", cpu);
+        }
+    }
+    if (config->sched_fifo_prio > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = config->sched_fifo_prio;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            log_printf("pthread_setschedparam: SCHED_FIFO priority %d: %s\n", config->sched_fifo_prio, strerror(rc));
+        } else {
+            log_printf("SCHED_FIFO priority %d\n", config->sched_fifo_prio);
+        }
+    }
+}
+
+static void apply_mlockall(const Config *config) {
+    if (!config->mlock_all) {
+        return;
+    }
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        log_printf("mlockall: %s\n", strerror(errno));
+    } else {
+        log_printf("Memory locked\n");
+    }
+}
+
+static void log_rates(ChannelWeight *weights, int channels, int channel_offset, double total_weight, double rate_hz) {
+    log_printf("Effective per-channel rates (Hz):\n");
     for (int i = 0; i < channels; i++) {
         double rate = total_weight > 0.0 ? (weights[i].weight / total_weight) * rate_hz : 0.0;
-        printf("  ch %d: %.2f\n", weights[i].channel, rate);
+        log_printf("  ch %d: %.2f\n", weights[i].channel + channel_offset, rate);
     }
 }
 
-static ssize_t send_all(int fd, const char *buffer, size_t len) {
-    size_t total = 0;
-    while (total < len) {
-        ssize_t sent = send(fd, buffer + total, len - total, 0);
+static char *write_uint(char *p, unsigned long long value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+static char *write_int(char *p, long long value) {
+    if (value < 0) {
+        *p++ = '-';
+        return write_uint(p, (unsigned long long)(-(value + 1)) + 1ULL);
+    }
+    return write_uint(p, (unsigned long long)value);
+}
+
+static char *write_text(char *p, const char *text, size_t len) {
+    memcpy(p, text, len);
+    return p + len;
+}
+
+#define WRITE_LITERAL(p, s) write_text((p), (s), sizeof(s) - 1)
+
+static char *write_bool(char *p, bool value) {
+    return value ? WRITE_LITERAL(p, "true") : WRITE_LITERAL(p, "false");
+}
+
+/* Writes one NDJSON line into out (at least EVENT_MAX_LEN bytes) and returns its length. */
+static size_t encode_event(const SimEvent *ev, char *out) {
+    char *p = out;
+    p = WRITE_LITERAL(p, "{\"t_us\":");
+    p = write_int(p, ev->t_us);
+    p = WRITE_LITERAL(p, ",\"channel\":");
+    p = write_int(p, ev->channel);
+    p = WRITE_LITERAL(p, ",\"adc_x\":");
+    p = write_int(p, ev->adc_x);
+    p = WRITE_LITERAL(p, ",\"adc_gtop\":");
+    p = write_int(p, ev->adc_gtop);
+    p = WRITE_LITERAL(p, ",\"adc_gbot\":");
+    p = write_int(p, ev->adc_gbot);
+    p = WRITE_LITERAL(p, ",\"flags\":{\"trg_x\":");
+    p = write_bool(p, ev->trg_x);
+    p = WRITE_LITERAL(p, ",\"trg_g\":");
+    p = write_bool(p, ev->trg_g);
+    p = WRITE_LITERAL(p, ",\"no_data\":");
+    p = write_bool(p, ev->no_data);
+    p = WRITE_LITERAL(p, ",\"is_g_event\":");
+    p = write_bool(p, ev->is_g_event);
+    p = WRITE_LITERAL(p, "}}\n");
+    return (size_t)(p - out);
+}
+
+/*
+ * Bounded byte queue between the generator and the non-blocking client socket. It only ever holds
+ * whole NDJSON lines, so head always sits on an event boundary and drop-oldest can evict by
+ * skipping to the next newline. Bytes move to the in-flight buffer (event-aligned) before send(),
+ * which lets the queue head stay droppable while a partial send is pending.
+ */
+typedef struct {
+    char *data;
+    size_t capacity;
+    size_t head;
+    size_t len;
+    size_t peak_len;
+    QueuePolicy policy;
+    char inflight[INFLIGHT_SIZE];
+    size_t inflight_off;
+    size_t inflight_len;
+    size_t inflight_lines; /* lines in a compressed in-flight frame, counted once it is sent */
+    size_t inflight_split; /* --fault-split: end a send() at this in-flight offset; 0 = none */
+} OutputQueue;
+
+static void init_output_queue(OutputQueue *q, size_t capacity, QueuePolicy policy) {
+    q->data = (char *)malloc(capacity);
+    if (!q->data) {
+        log_printf("Out of memory allocating %zu byte output queue\n", capacity);
+        exit(1);
+    }
+    q->capacity = capacity;
+    q->head = 0;
+    q->len = 0;
+    q->peak_len = 0;
+    q->policy = policy;
+    q->inflight_off = 0;
+    q->inflight_len = 0;
+    q->inflight_lines = 0;
+    q->inflight_split = 0;
+}
+
+static void free_output_queue(OutputQueue *q) {
+    free(q->data);
+    q->data = NULL;
+}
+
+static void queue_write(OutputQueue *q, const char *bytes, size_t len) {
+    size_t tail = (q->head + q->len) % q->capacity;
+    size_t first = q->capacity - tail < len ? q->capacity - tail : len;
+    memcpy(q->data + tail, bytes, first);
+    memcpy(q->data, bytes + first, len - first);
+    q->len += len;
+    if (q->len > q->peak_len) {
+        q->peak_len = q->len;
+    }
+}
+
+static size_t queue_read(const OutputQueue *q, char *out, size_t len) {
+    size_t first = q->capacity - q->head < len ? q->capacity - q->head : len;
+    memcpy(out, q->data + q->head, first);
+    memcpy(out + first, q->data, len - first);
+    return len;
+}
+
+static void queue_consume(OutputQueue *q, size_t len) {
+    q->head = (q->head + len) % q->capacity;
+    q->len -= len;
+}
+
+/* Removes the oldest queued line and returns its length in bytes. */
+static size_t queue_drop_oldest(OutputQueue *q) {
+    size_t i = 0;
+    while (i < q->len && q->data[(q->head + i) % q->capacity] != '\n') {
+        i++;
+    }
+    size_t dropped = i < q->len ? i + 1 : q->len;
+    queue_consume(q, dropped);
+    return dropped;
+}
+
+/* Moves whole lines from the queue head into the in-flight buffer. */
+static void queue_refill_inflight(OutputQueue *q) {
+    if (q->inflight_off < q->inflight_len || q->len == 0) {
+        return;
+    }
+    size_t take = q->len < INFLIGHT_SIZE ? q->len : INFLIGHT_SIZE;
+    queue_read(q, q->inflight, take);
+    while (take < q->len && take > 0 && q->inflight[take - 1] != '\n') {
+        take--;
+    }
+    if (take == 0) {
+        take = q->len < INFLIGHT_SIZE ? q->len : INFLIGHT_SIZE;
+    }
+    queue_consume(q, take);
+    q->inflight_off = 0;
+    q->inflight_len = take;
+}
+
+static size_t count_lines(const char *bytes, size_t len) {
+    size_t lines = 0;
+    const char *end = bytes + len;
+    while (bytes < end) {
+        const char *nl = memchr(bytes, '\n', (size_t)(end - bytes));
+        if (!nl) {
+            break;
+        }
+        lines++;
+        bytes = nl + 1;
+    }
+    return lines;
+}
+
+/*
+ * Framed deflate for the client stream (docs/02-Data-Contract.md, section D). One raw deflate
+ * stream primed with compress_dictionary runs for the whole connection and every frame ends on a
+ * Z_SYNC_FLUSH, so the receiver can decode each frame as soon as it arrives. Frames are
+ * `u32 compressed length, u32 decoded length` (little-endian) followed by the deflate bytes.
+ */
+typedef struct {
+    bool enabled;
+    z_stream zs;
+    size_t block_bytes;
+    long long flush_us;
+    long long last_frame_us;
+    char *raw;             /* block_bytes of queued lines being framed */
+    unsigned char *frame;  /* frame_cap bytes, for writes that bypass the queue */
+    size_t frame_cap;
+    unsigned long long raw_total;
+    unsigned long long wire_total;
+    unsigned long long raw_interval;
+    unsigned long long wire_interval;
+    long long cpu_ns_total;
+    long long cpu_ns_interval;
+} Compressor;
+
+/* Two typical event lines; must match backend/src/stream_compression.py byte for byte. */
+static const char compress_dictionary[] =
+    "{\"t_us\":1700000000000123,\"channel\":3,\"adc_x\":1712,\"adc_gtop\":2540,\"adc_gbot\":2466,"
+    "\"flags\":{\"trg_x\":true,\"trg_g\":true,\"no_data\":false,\"is_g_event\":true}}\n"
+    "{\"t_us\":1700000000000000,\"channel\":12,\"adc_x\":2048,\"adc_gtop\":2311,\"adc_gbot\":1998,"
+    "\"flags\":{\"trg_x\":false,\"trg_g\":false,\"no_data\":false,\"is_g_event\":false}}\n";
+
+static void init_compressor(Compressor *c, const Config *config) {
+    memset(&c->zs, 0, sizeof(c->zs));
+    if (deflateInit2(&c->zs, config->compress_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK ||
+        deflateSetDictionary(&c->zs, (const Bytef *)compress_dictionary, sizeof(compress_dictionary) - 1) != Z_OK) {
+        log_printf("deflateInit failed\n");
+        exit(1);
+    }
+    c->enabled = true;
+    c->block_bytes = config->compress_block;
+    c->flush_us = (long long)config->compress_flush_ms * 1000LL;
+    c->last_frame_us = now_us();
+    /* A sync flush adds at most a few bytes on top of deflateBound. */
+    c->frame_cap = COMPRESS_FRAME_HEADER + deflateBound(&c->zs, (uLong)c->block_bytes) + 16;
+    c->raw = (char *)malloc(c->block_bytes);
+    c->frame = (unsigned char *)malloc(c->frame_cap);
+    if (!c->raw || !c->frame) {
+        log_printf("Out of memory allocating compression buffers\n");
+        exit(1);
+    }
+    c->raw_total = 0;
+    c->wire_total = 0;
+    c->raw_interval = 0;
+    c->wire_interval = 0;
+    c->cpu_ns_total = 0;
+    c->cpu_ns_interval = 0;
+}
+
+static void free_compressor(Compressor *c) {
+    if (!c->enabled) {
+        return;
+    }
+    deflateEnd(&c->zs);
+    free(c->raw);
+    free(c->frame);
+    c->enabled = false;
+}
+
+static void put_u32_le(unsigned char *p, uint32_t value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+/* Compresses len <= block_bytes bytes into one frame at out (cap >= frame_cap); returns its size, 0 on error. */
+static size_t compress_frame(Compressor *c, const char *raw, size_t len, unsigned char *out, size_t cap) {
+    long long cpu_start = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    c->zs.next_in = (Bytef *)raw;
+    c->zs.avail_in = (uInt)len;
+    c->zs.next_out = out + COMPRESS_FRAME_HEADER;
+    c->zs.avail_out = (uInt)(cap - COMPRESS_FRAME_HEADER);
+    if (deflate(&c->zs, Z_SYNC_FLUSH) != Z_OK || c->zs.avail_in != 0 || c->zs.avail_out == 0) {
+        log_printf("deflate failed\n");
+        return 0;
+    }
+    size_t wire = cap - COMPRESS_FRAME_HEADER - c->zs.avail_out;
+    put_u32_le(out, (uint32_t)wire);
+    put_u32_le(out + 4, (uint32_t)len);
+    long long cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    QL_PROBE3(compress_frame, len, wire, cpu_ns);
+    c->cpu_ns_total += cpu_ns;
+    c->cpu_ns_interval += cpu_ns;
+    c->raw_total += len;
+    c->raw_interval += len;
+    c->wire_total += wire + COMPRESS_FRAME_HEADER;
+    c->wire_interval += wire + COMPRESS_FRAME_HEADER;
+    c->last_frame_us = now_us();
+    return wire + COMPRESS_FRAME_HEADER;
+}
+
+static bool compress_due(const Compressor *c, const OutputQueue *q) {
+    return q->len >= c->block_bytes || now_us() - c->last_frame_us >= c->flush_us;
+}
+
+/*
+ * Compressed counterpart of queue_refill_inflight: once a block of whole lines is queued, or the
+ * oldest unsent data is --compress-flush-ms old, it becomes one frame in the in-flight buffer.
+ */
+static bool queue_refill_compressed(OutputQueue *q, Compressor *c) {
+    if (q->inflight_off < q->inflight_len || q->len == 0 || !compress_due(c, q)) {
+        return true;
+    }
+    size_t take = q->len < c->block_bytes ? q->len : c->block_bytes;
+    queue_read(q, c->raw, take);
+    while (take < q->len && take > 0 && c->raw[take - 1] != '\n') {
+        take--;
+    }
+    if (take == 0) {
+        take = q->len < c->block_bytes ? q->len : c->block_bytes;
+    }
+    size_t frame = compress_frame(c, c->raw, take, (unsigned char *)q->inflight, INFLIGHT_SIZE);
+    if (frame == 0) {
+        return false;
+    }
+    queue_consume(q, take);
+    q->inflight_off = 0;
+    q->inflight_len = frame;
+    q->inflight_lines = count_lines(c->raw, take);
+    return true;
+}
+
+typedef struct {
+    int fd;
+    OutputQueue queue;
+    char scratch[EVENT_MAX_LEN];
+    double drop_rate;
+    int stats_interval_s;
+    long long last_stats_us;
+    unsigned long long sent_total;
+    unsigned long long dropped_total;
+    unsigned long long queue_dropped_total;
+    unsigned long long queue_dropped_bytes_total;
+    unsigned long long sent_interval;
+    unsigned long long dropped_interval;
+    unsigned long long queue_dropped_interval;
+    unsigned long long queue_dropped_bytes_interval;
+    int counts_interval[MAX_CHANNELS];
+    int count_slots;
+    const char *slot_prefix;
+    int slot_base;
+    Pacer *pacer;
+    const FaultConfig *faults;
+    FaultKind fault_burst_kind;
+    int fault_burst_remaining;
+    char *fault_buffer;
+    unsigned long long fault_totals[FAULT_KINDS];
+    unsigned long long faults_interval;
+    Compressor compress;
+    bool failed;
+} Emitter;
+
+static void init_emitter(Emitter *em, int fd, const Config *config, Pacer *pacer, int count_slots, const char *slot_prefix) {
+    em->fd = fd;
+    em->pacer = pacer;
+    init_output_queue(&em->queue, config->queue_bytes, config->queue_policy);
+    em->drop_rate = config->drop_rate;
+    em->stats_interval_s = config->stats_interval_s;
+    em->last_stats_us = now_us();
+    em->sent_total = 0;
+    em->dropped_total = 0;
+    em->queue_dropped_total = 0;
+    em->queue_dropped_bytes_total = 0;
+    em->sent_interval = 0;
+    em->dropped_interval = 0;
+    em->queue_dropped_interval = 0;
+    em->queue_dropped_bytes_interval = 0;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        em->counts_interval[i] = 0;
+    }
+    em->count_slots = count_slots;
+    em->slot_prefix = slot_prefix;
+    em->slot_base = 0;
+    em->faults = &config->faults;
+    em->fault_burst_kind = FAULT_NONE;
+    em->fault_burst_remaining = 0;
+    em->fault_buffer = NULL;
+    if (config->faults.prob[FAULT_OVERSIZE] > 0.0) {
+        em->fault_buffer = (char *)malloc((size_t)config->faults.oversize_bytes + EVENT_MAX_LEN);
+        if (!em->fault_buffer) {
+            log_printf("Out of memory allocating oversize fault buffer\n");
+            exit(1);
+        }
+    }
+    memset(em->fault_totals, 0, sizeof(em->fault_totals));
+    em->faults_interval = 0;
+    em->compress.enabled = false;
+    em->failed = false;
+    if (config->faults.prob[FAULT_SPLIT] > 0.0) {
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+}
+
+/*
+ * Sends as much queued data as the socket accepts without blocking. sent counts lines that
+ * actually left through send(), not lines that were generated.
+ */
+static void emitter_pump(Emitter *em) {
+    OutputQueue *q = &em->queue;
+    size_t flushed = 0;
+    QL_PROBE2(flush_start, q->len, q->inflight_len - q->inflight_off);
+    while (!em->failed) {
+        if (!em->compress.enabled) {
+            queue_refill_inflight(q);
+        } else if (!queue_refill_compressed(q, &em->compress)) {
+            em->failed = true;
+            break;
+        }
+        if (q->inflight_off == q->inflight_len) {
+            break;
+        }
+        const char *pending = q->inflight + q->inflight_off;
+        size_t want = q->inflight_len - q->inflight_off;
+        if (q->inflight_split > q->inflight_off) {
+            want = q->inflight_split - q->inflight_off;
+        }
+        ssize_t sent = send(em->fd, pending, want, MSG_DONTWAIT);
         if (sent < 0) {
             if (errno == EINTR) {
                 continue;
             }
-            return -1;
-        }
-        if (sent == 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                QL_PROBE2(send_blocked, q->len, q->inflight_len - q->inflight_off);
+                break;
+            }
+            log_printf("send: %s\n", strerror(errno));
+            em->failed = true;
             break;
         }
-        total += (size_t)sent;
+        flushed += (size_t)sent;
+        if (em->compress.enabled) {
+            q->inflight_off += (size_t)sent;
+            if (q->inflight_off == q->inflight_len) {
+                em->sent_total += q->inflight_lines;
+                em->sent_interval += q->inflight_lines;
+            }
+            continue;
+        }
+        size_t lines = count_lines(pending, (size_t)sent);
+        em->sent_total += lines;
+        em->sent_interval += lines;
+        q->inflight_off += (size_t)sent;
+        if (q->inflight_off >= q->inflight_split) {
+            q->inflight_split = 0;
+        }
     }
-    return (ssize_t)total;
+    QL_PROBE2(flush_end, flushed, q->len);
 }
 
-static void flush_out_buffer(int fd, char *out_buffer, size_t *out_len) {
-    if (*out_len == 0) {
+/* Waits up to timeout_ms for the socket to become writable, then pumps. */
+static void emitter_wait_writable(Emitter *em, int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = em->fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR) {
+        log_printf("poll: %s\n", strerror(errno));
+        em->failed = true;
         return;
     }
-    if (send_all(fd, out_buffer, *out_len) < 0) {
-        perror("send");
+    if (pfd.revents & (POLLERR | POLLHUP)) {
+        log_printf("send: client disconnected\n");
+        em->failed = true;
+        return;
     }
-    *out_len = 0;
+    emitter_pump(em);
 }
 
-static void print_stats_header(void) {
-    printf("Stats: elapsed_s sent_rate_hz sent dropped per_channel_counts\n");
+/* Drains the queue before shutdown, giving a slow consumer at most timeout_ms. */
+static void emitter_drain(Emitter *em, int timeout_ms) {
+    long long deadline = now_us() + (long long)timeout_ms * 1000LL;
+    em->compress.flush_us = 0;
+    emitter_pump(em);
+    while (!em->failed && (em->queue.len > 0 || em->queue.inflight_off < em->queue.inflight_len) && now_us() < deadline) {
+        emitter_wait_writable(em, 50);
+    }
 }
 
-static void print_stats(double elapsed_s, unsigned long long sent_delta, unsigned long long dropped_delta, int *counts, int channels) {
-    double rate = elapsed_s > 0.0 ? (double)sent_delta / elapsed_s : 0.0;
-    printf("Stats: %.2f %.2f %llu %llu", elapsed_s, rate, sent_delta, dropped_delta);
-    for (int i = 0; i < channels; i++) {
-        printf(" ch%d=%d", i, counts[i]);
+static void emitter_count_queue_drop(Emitter *em, size_t bytes) {
+    em->queue_dropped_total++;
+    em->queue_dropped_interval++;
+    em->queue_dropped_bytes_total += bytes;
+    em->queue_dropped_bytes_interval += bytes;
+}
+
+/*
+ * Appends one encoded line, applying --queue-policy when it does not fit. Returns false when the
+ * line itself was rejected.
+ */
+static bool emitter_enqueue(Emitter *em, const char *bytes, size_t len) {
+    OutputQueue *q = &em->queue;
+    while (q->capacity - q->len < len) {
+        if (q->policy == QUEUE_DROP_NEWEST) {
+            emitter_count_queue_drop(em, len);
+            return false;
+        }
+        if (q->policy == QUEUE_DROP_OLDEST) {
+            emitter_count_queue_drop(em, queue_drop_oldest(q));
+            continue;
+        }
+        QL_PROBE2(queue_full, q->len, len);
+        emitter_wait_writable(em, 100);
+        if (em->failed || stop_requested) {
+            return false;
+        }
+    }
+    queue_write(q, bytes, len);
+    if (q->len >= OUT_BUFFER_SIZE || (em->compress.enabled && compress_due(&em->compress, q))) {
+        emitter_pump(em);
+    }
+    return true;
+}
+
+static FaultKind pick_fault(Emitter *em) {
+    if (em->fault_burst_remaining > 0) {
+        em->fault_burst_remaining--;
+        return em->fault_burst_kind;
+    }
+    for (int k = FAULT_NONE + 1; k < FAULT_KINDS; k++) {
+        if (em->faults->prob[k] > 0.0 && uniform_rand() < em->faults->prob[k]) {
+            em->fault_burst_kind = (FaultKind)k;
+            em->fault_burst_remaining = em->faults->burst_len - 1;
+            return (FaultKind)k;
+        }
+    }
+    return FAULT_NONE;
+}
+
+/* Flips a few bits inside the line body, never producing or removing a newline. */
+static void corrupt_line(char *line, size_t len) {
+    int flips = 1 + rng_u32() % 3;
+    for (int i = 0; i < flips && len > 1; i++) {
+        size_t pos = (size_t)rng_u32() % (len - 1);
+        char flipped = (char)(line[pos] ^ (char)(1 << (rng_u32() % 8)));
+        if (flipped != '\n') {
+            line[pos] = flipped;
+        }
+    }
+}
+
+/* Builds a valid but oversized line by prefixing a padding field to the encoded event. */
+static size_t build_oversize_line(Emitter *em, const char *line, size_t len) {
+    char *p = em->fault_buffer;
+    size_t pad = (size_t)em->faults->oversize_bytes > len + 12 ? (size_t)em->faults->oversize_bytes - len - 12 : 0;
+    p = WRITE_LITERAL(p, "{\"pad\":\"");
+    memset(p, 'x', pad);
+    p += pad;
+    p = WRITE_LITERAL(p, "\",");
+    p = write_text(p, line + 1, len - 1);
+    return (size_t)(p - em->fault_buffer);
+}
+
+/*
+ * Hands the whole line to the in-flight buffer with a cut point, so emitter_pump sends the part
+ * before the cut in its own send() (TCP_NODELAY is on) and the receiver sees the line split across
+ * reads. The queue itself only ever holds whole lines. Only possible when nothing else is pending.
+ */
+static bool emit_split_line(Emitter *em, const char *line, size_t len) {
+    OutputQueue *q = &em->queue;
+    emitter_pump(em);
+    if (q->len > 0 || q->inflight_off < q->inflight_len || len < 2 || len > INFLIGHT_SIZE) {
+        return false;
+    }
+    memcpy(q->inflight, line, len);
+    q->inflight_off = 0;
+    q->inflight_len = len;
+    q->inflight_split = 1 + (size_t)rng_u32() % (len - 1);
+    emitter_pump(em);
+    return true;
+}
+
+static void emit_faulty_event(Emitter *em, const SimEvent *ev, int count_slot) {
+    FaultKind fault = pick_fault(em);
+    SimEvent mutated = *ev;
+    if (fault == FAULT_BAD_CHANNEL) {
+        mutated.channel = (rng_u32() & 1) ? -1 - (int)(rng_u32() % 8) : 100000 + (int)(rng_u32() % 1000);
+    } else if (fault == FAULT_TIME_REVERSE) {
+        mutated.t_us -= 1 + rng_u32() % 1000000;
+    }
+
+    const char *line = em->scratch;
+    size_t len = encode_event(&mutated, em->scratch);
+    if (fault == FAULT_TRUNCATE) {
+        len = 1 + (size_t)rng_u32() % (len - 2);
+        em->scratch[len++] = '\n';
+    } else if (fault == FAULT_CORRUPT) {
+        corrupt_line(em->scratch, len);
+    } else if (fault == FAULT_OVERSIZE) {
+        len = build_oversize_line(em, em->scratch, len);
+        line = em->fault_buffer;
+    }
+
+    bool queued;
+    /* Under compression a split would land inside a frame, so lines go out whole. */
+    if (fault == FAULT_SPLIT && !em->compress.enabled && emit_split_line(em, line, len)) {
+        queued = true;
+    } else {
+        if (fault == FAULT_SPLIT) {
+            fault = FAULT_NONE;
+        }
+        queued = emitter_enqueue(em, line, len);
+    }
+    if (!queued) {
+        return;
+    }
+    if (fault != FAULT_NONE) {
+        em->fault_totals[fault]++;
+        em->faults_interval++;
+    }
+    if (count_slot >= 0 && count_slot < em->count_slots) {
+        em->counts_interval[count_slot] += 1;
+    }
+}
+
+/* Encodes ev, applies --drop-rate and fault injection, and queues it. count_slot selects the stats bucket. */
+static void emit_event(Emitter *em, const SimEvent *ev, int count_slot) {
+    if (uniform_rand() < em->drop_rate) {
+        em->dropped_total++;
+        em->dropped_interval++;
+        return;
+    }
+    if (em->faults->enabled) {
+        emit_faulty_event(em, ev, count_slot);
+        return;
+    }
+    size_t len = encode_event(ev, em->scratch);
+    if (!emitter_enqueue(em, em->scratch, len)) {
+        return;
+    }
+    if (count_slot >= 0 && count_slot < em->count_slots) {
+        em->counts_interval[count_slot] += 1;
+    }
+}
+
+static void print_stats_header(const char *count_label) {
+    log_printf("Stats: elapsed_s sent_rate_hz sent dropped queue_dropped queue_dropped_bytes queue_peak_bytes faults "
+           "jitter_p50_us jitter_p99_us jitter_p999_us jitter_max_us per_%s_counts\n", count_label);
+}
+
+static void print_stats(double elapsed_s, const Emitter *em) {
+    const JitterStats *jitter = &em->pacer->jitter;
+    double rate = elapsed_s > 0.0 ? (double)em->sent_interval / elapsed_s : 0.0;
+    char line[4096];
+    int len = snprintf(line, sizeof(line), "Stats: %.2f %.2f %llu %llu %llu %llu %zu %llu %lld %lld %lld %.1f",
+        elapsed_s, rate, em->sent_interval, em->dropped_interval,
+        em->queue_dropped_interval, em->queue_dropped_bytes_interval, em->queue.peak_len, em->faults_interval,
+        jitter_percentile_us(jitter, 0.50),
+        jitter_percentile_us(jitter, 0.99),
+        jitter_percentile_us(jitter, 0.999),
+        jitter->max_ns / 1000.0);
+    for (int i = 0; i < em->count_slots && len > 0 && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - (size_t)len, " %s%d=%d", em->slot_prefix, em->slot_base + i, em->counts_interval[i]);
+    }
+    log_printf("%s\n", line);
+    const Compressor *c = &em->compress;
+    if (c->enabled) {
+        log_printf("Compression: raw_bytes=%llu wire_bytes=%llu ratio=%.2f cpu_ms=%.1f cpu_ns_per_raw_byte=%.2f\n",
+            c->raw_interval, c->wire_interval, c->wire_interval ? (double)c->raw_interval / (double)c->wire_interval : 0.0,
+            c->cpu_ns_interval / 1e6, c->raw_interval ? (double)c->cpu_ns_interval / (double)c->raw_interval : 0.0);
+    }
+}
+
+/* Prints interval stats and pushes pending output once per --stats-interval. */
+static void emitter_tick(Emitter *em) {
+    long long now_stats = now_us();
+    if (now_stats - em->last_stats_us < (long long)em->stats_interval_s * 1000000LL) {
+        return;
+    }
+    emitter_pump(em);
+    double elapsed_s = (now_stats - em->last_stats_us) / 1000000.0;
+    QL_PROBE3(stats_tick, em->sent_interval, em->dropped_interval + em->queue_dropped_interval, em->queue.peak_len);
+    print_stats(elapsed_s, em);
+    memset(&em->pacer->jitter, 0, sizeof(em->pacer->jitter));
+    em->last_stats_us = now_stats;
+    em->sent_interval = 0;
+    em->dropped_interval = 0;
+    em->queue_dropped_interval = 0;
+    em->queue_dropped_bytes_interval = 0;
+    em->faults_interval = 0;
+    em->compress.raw_interval = 0;
+    em->compress.wire_interval = 0;
+    em->compress.cpu_ns_interval = 0;
+    em->queue.peak_len = em->queue.len;
+    for (int i = 0; i < em->count_slots; i++) {
+        em->counts_interval[i] = 0;
     }
-    printf("\n");
 }
 
 static void choose_burst_channels(bool *burst_channels, int channels) {
@@ -507,186 +1971,813 @@ static void choose_burst_channels(bool *burst_channels, int channels) {
         burst_channels[i] = false;
     }
     for (int i = 0; i < burst_count; i++) {
-        int ch = rand() % channels;
+        int ch = rng_u32() % channels;
         burst_channels[ch] = true;
     }
 }
 
-int main(int argc, char **argv) {
-    Config config;
-    parse_args(argc, argv, &config);
+static bool ndjson_find_int(const char *line, const char *key, long long *out) {
+    const char *p = strstr(line, key);
+    if (!p) {
+        return false;
+    }
+    char *end = NULL;
+    long long value = strtoll(p + strlen(key), &end, 10);
+    if (end == p + strlen(key)) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+static bool ndjson_find_bool(const char *line, const char *key) {
+    const char *p = strstr(line, key);
+    return p && strncmp(p + strlen(key), "true", 4) == 0;
+}
+
+/* Parses one recorded event line; lines missing a required field are rejected. */
+static bool parse_recorded_line(const char *line, SimEvent *ev) {
+    long long t_us, channel, adc_x, adc_gtop, adc_gbot;
+    if (!ndjson_find_int(line, "\"t_us\":", &t_us) ||
+        !ndjson_find_int(line, "\"channel\":", &channel) ||
+        !ndjson_find_int(line, "\"adc_x\":", &adc_x) ||
+        !ndjson_find_int(line, "\"adc_gtop\":", &adc_gtop) ||
+        !ndjson_find_int(line, "\"adc_gbot\":", &adc_gbot)) {
+        return false;
+    }
+    if (t_us <= 0 || channel < 0) {
+        return false;
+    }
+    ev->t_us = t_us;
+    ev->channel = (int)channel;
+    ev->adc_x = clamp_adc((int)adc_x);
+    ev->adc_gtop = clamp_adc((int)adc_gtop);
+    ev->adc_gbot = clamp_adc((int)adc_gbot);
+    ev->trg_x = ndjson_find_bool(line, "\"trg_x\":");
+    ev->trg_g = ndjson_find_bool(line, "\"trg_g\":");
+    ev->no_data = ndjson_find_bool(line, "\"no_data\":");
+    ev->is_g_event = ndjson_find_bool(line, "\"is_g_event\":");
+    return true;
+}
 
-    if (config.has_seed) {
-        srand(config.seed);
+static size_t load_ndjson_recording(char *data, size_t len, SimEvent *events, size_t capacity) {
+    size_t count = 0;
+    char *line = data;
+    char *end = data + len;
+    while (line < end && count < capacity) {
+        char *nl = memchr(line, '\n', (size_t)(end - line));
+        if (nl) {
+            *nl = '\0';
+        }
+        if (parse_recorded_line(line, &events[count])) {
+            count++;
+        }
+        if (!nl) {
+            break;
+        }
+        line = nl + 1;
+    }
+    return count;
+}
+
+static uint64_t read_le(const unsigned char *p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/*
+ * Decodes lab subrecords (u32 raw_id + u64 word) the same way hardware_adapter/adapter.py does:
+ * t_us = unwrapped ticks / 10. Only differences between recorded times are used for pacing.
+ */
+static size_t load_binary_recording(const unsigned char *data, size_t len, SimEvent *events, size_t capacity) {
+    uint32_t raw_ids[MAX_CHANNELS];
+    int mapped = 0;
+    long long wrap_offset = 0;
+    long long last_ticks = -1;
+    size_t count = 0;
+    for (size_t off = 0; off + LAB_SUBRECORD_SIZE <= len && count < capacity; off += LAB_SUBRECORD_SIZE) {
+        uint32_t raw_id = (uint32_t)read_le(data + off, 4);
+        uint64_t word = read_le(data + off + 4, 8);
+        int channel = -1;
+        for (int i = 0; i < mapped; i++) {
+            if (raw_ids[i] == raw_id) {
+                channel = i;
+                break;
+            }
+        }
+        if (channel < 0) {
+            if (mapped >= MAX_CHANNELS) {
+                continue;
+            }
+            raw_ids[mapped] = raw_id;
+            channel = mapped++;
+        }
+
+        long long ticks = (long long)((word >> 2) & 0xFFFFFF) + wrap_offset;
+        if (last_ticks >= 0 && last_ticks - ticks > LAB_UNWRAP_THRESHOLD_TICKS) {
+            wrap_offset += LAB_PPS_TICKS;
+            ticks += LAB_PPS_TICKS;
+        }
+        last_ticks = ticks;
+
+        bool no_data = (word >> 63) & 0x1;
+        if (no_data) {
+            continue;
+        }
+        SimEvent *ev = &events[count++];
+        ev->t_us = ticks / 10;
+        ev->channel = channel;
+        ev->adc_x = (int)((word >> 51) & 0xFFF);
+        ev->adc_gtop = (int)((word >> 39) & 0xFFF);
+        ev->adc_gbot = (int)((word >> 27) & 0xFFF);
+        ev->is_g_event = (word >> 26) & 0x1;
+        ev->trg_g = (word >> 1) & 0x1;
+        ev->trg_x = word & 0x1;
+        ev->no_data = false;
+    }
+    return count;
+}
+
+static int compare_event_time(const void *a, const void *b) {
+    long long ta = ((const SimEvent *)a)->t_us;
+    long long tb = ((const SimEvent *)b)->t_us;
+    return (ta > tb) - (ta < tb);
+}
+
+static void load_recording(const Config *config, Recording *rec) {
+    size_t len = 0;
+    char *data = (char *)read_file(config->amplify_path, &len);
+    if (!data) {
+        fprintf(stderr, "Failed to read recording: %s\n", config->amplify_path);
+        exit(1);
+    }
+    size_t capacity = config->amplify_format == EVENT_FORMAT_BINARY ? len / LAB_SUBRECORD_SIZE : len / 16;
+    rec->events = (SimEvent *)malloc((capacity + 1) * sizeof(SimEvent));
+    if (!rec->events) {
+        fprintf(stderr, "Out of memory loading recording: %s\n", config->amplify_path);
+        exit(1);
+    }
+    if (config->amplify_format == EVENT_FORMAT_BINARY) {
+        rec->count = load_binary_recording((const unsigned char *)data, len, rec->events, capacity);
     } else {
-        srand((unsigned int)time(NULL));
+        rec->count = load_ndjson_recording(data, len, rec->events, capacity);
+    }
+    free(data);
+    if (rec->count == 0) {
+        fprintf(stderr, "Recording has no usable events: %s\n", config->amplify_path);
+        exit(1);
     }
 
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
+    bool sorted = true;
+    rec->channel_span = 0;
+    for (size_t i = 0; i < rec->count; i++) {
+        if (i > 0 && rec->events[i].t_us < rec->events[i - 1].t_us) {
+            sorted = false;
+        }
+        if (rec->events[i].channel + 1 > rec->channel_span) {
+            rec->channel_span = rec->events[i].channel + 1;
+        }
+    }
+    if (!sorted) {
+        qsort(rec->events, rec->count, sizeof(SimEvent), compare_event_time);
+    }
+}
 
-    ChannelWeight weights[MAX_CHANNELS];
-    init_channel_weights(weights, &config);
+/*
+ * Replays the recording as config->amplify_copies modules. Copy k starts k/copies of the way into
+ * the recording (time shift) and adds k * channel_offset to every channel, so each module keeps
+ * the recorded spectra and per-channel rate ratios. Every step of the primary cursor emits one event
+ * per copy, paced on the recorded timeline divided by --amplify-speed.
+ */
+static void run_amplified(Emitter *em, const Config *config, const Recording *rec) {
+    int copies = config->amplify_copies;
+    int channel_offset = config->amplify_channel_offset > 0 ? config->amplify_channel_offset : rec->channel_span;
+    size_t stride = rec->count / (size_t)copies;
+    long long rec_t0 = rec->events[0].t_us;
+    long long rec_span_us = rec->events[rec->count - 1].t_us - rec_t0;
+    long long loop_gap_us = rec->count > 1 ? rec_span_us / (long long)(rec->count - 1) : 1000;
+    if (loop_gap_us < 1) {
+        loop_gap_us = 1;
+    }
+    double speed = config->amplify_speed;
+
+    long long start_us = now_us();
+    long long start_ns = pacer_now_ns(em->pacer);
+    long long loop_base_us = 0;
+    size_t i = 0;
+    while (!stop_requested && !em->failed) {
+        long long offset_us = loop_base_us + (long long)((rec->events[i].t_us - rec_t0) / speed);
+        pacer_wait_until(em->pacer, start_ns + offset_us * 1000LL);
+
+        for (int k = 0; k < copies; k++) {
+            SimEvent ev = rec->events[(i + (size_t)k * stride) % rec->count];
+            ev.t_us = start_us + offset_us;
+            ev.channel += k * channel_offset;
+            emit_event(em, &ev, k);
+        }
+
+        if (++i == rec->count) {
+            i = 0;
+            loop_base_us += (long long)((rec_span_us + loop_gap_us) / speed);
+        }
+        emitter_tick(em);
+    }
+}
 
+static void run_synthetic(Emitter *em, Config *config, const ChannelWeight *weights) {
     bool burst_channels[MAX_CHANNELS];
     for (int i = 0; i < MAX_CHANNELS; i++) {
         burst_channels[i] = false;
     }
-    double total_weight = compute_total_weight(weights, config.channels, burst_channels, false);
 
-    int server_fd = setup_server(config.host, config.port);
-    printf("Simulator listening on %s:%d\n", config.host, config.port);
-    if (config.config_path) {
-        printf("Config: %s\n", config.config_path);
+    EventBatch *batch = (EventBatch *)malloc(sizeof(EventBatch));
+    if (!batch) {
+        log_printf("Out of memory allocating event batch\n");
+        exit(1);
     }
-    log_rates(weights, config.channels, total_weight, config.rate_hz);
+    init_event_batch(batch, config->channels);
+    build_channel_alias(batch, weights, burst_channels, false);
+    int batch_size = batch_size_for_rate(config->rate_hz);
+
+    double interval_s = 1.0 / config->rate_hz;
+    double interval_ns = interval_s * 1e9;
+    double interval_us = interval_s * 1e6;
+    long long start_ns = em->pacer->timeline->epoch_ns;
+    unsigned long long first_index = pacer_first_slot(em->pacer, interval_ns);
+    unsigned long long event_index = first_index;
+    long long t0_us = now_us() + config->clock_offset_us;
+    long long next_burst_us = now_us() + (long long)BURST_INTERVAL_S * 1000000LL;
+    long long burst_end_us = 0;
+    bool burst_active = false;
 
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
-    if (client_fd < 0) {
-        if (errno == EINTR) {
-            close(server_fd);
-            return 0;
+    while (!stop_requested && !em->failed) {
+        if (batch->next == batch->count) {
+            long long now = now_us();
+            if (config->burst_mode && !burst_active && now >= next_burst_us) {
+                burst_active = true;
+                burst_end_us = now + (long long)BURST_DURATION_S * 1000000LL;
+                choose_burst_channels(burst_channels, config->channels);
+                build_channel_alias(batch, weights, burst_channels, true);
+                QL_PROBE1(burst_toggle, 1);
+            }
+            if (burst_active && now >= burst_end_us) {
+                burst_active = false;
+                next_burst_us = now + (long long)BURST_INTERVAL_S * 1000000LL;
+                build_channel_alias(batch, weights, burst_channels, false);
+                QL_PROBE1(burst_toggle, 0);
+            }
+            QL_PROBE1(batch_start, batch_size);
+            fill_event_batch(batch, &config->dist, batch_size);
+            QL_PROBE2(batch_generated, batch_size, burst_active);
         }
-        perror("accept");
-        close(server_fd);
-        return 1;
+
+        SimEvent ev;
+        int local_channel = next_batch_event(batch, &ev);
+        /* Stamped from the event index like the pacer deadline, so rates whose interval is not a
+         * whole number of microseconds do not drift. */
+        ev.t_us = t0_us + (long long)((double)(event_index - first_index) * interval_us);
+        ev.channel += config->channel_offset;
+
+        emit_event(em, &ev, local_channel);
+
+        event_index++;
+        pacer_wait_until(em->pacer, start_ns + (long long)((double)event_index * interval_ns));
+
+        emitter_tick(em);
     }
+    free(batch);
+}
 
-    char client_ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
-    printf("Client connected: %s:%d\n", client_ip, ntohs(client_addr.sin_port));
+/*
+ * Pre-rendered event pool for transport and backend stress tests. Events are drawn once from the
+ * batch generator and encoded back to back; at runtime only the timestamp of each event is
+ * rewritten in place and whole slices of the pool go out with writev().
+ */
+typedef struct {
+    char *data;
+    size_t *offsets; /* count + 1 entries; offsets[count] is the pool length */
+    uint8_t *channels; /* local channel per event, for the per-channel stats */
+    size_t count;
+    EventFormat format;
+} EventPool;
+
+/* Right-aligned in POOL_T_US_WIDTH columns, space padded, so every patch has the same width. */
+static void patch_ndjson_t_us(char *field, long long t_us) {
+    char *p = field + POOL_T_US_WIDTH;
+    unsigned long long value = t_us > 0 ? (unsigned long long)t_us : 0;
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0 && p > field);
+    while (p > field) {
+        *--p = ' ';
+    }
+}
 
-    double interval_s = 1.0 / config.rate_hz;
-    long long t_us = now_us();
-    long long last_stats_us = now_us();
-    long long next_burst_us = now_us() + (long long)BURST_INTERVAL_S * 1000000LL;
-    long long burst_end_us = 0;
-    bool burst_active = false;
+static uint64_t lab_word(const SimEvent *ev) {
+    return ((uint64_t)(ev->no_data ? 1 : 0) << 63)
+        | ((uint64_t)(ev->adc_x & 0xFFF) << 51)
+        | ((uint64_t)(ev->adc_gtop & 0xFFF) << 39)
+        | ((uint64_t)(ev->adc_gbot & 0xFFF) << 27)
+        | ((uint64_t)(ev->is_g_event ? 1 : 0) << 26)
+        | ((uint64_t)(ev->trg_g ? 1 : 0) << 1)
+        | (uint64_t)(ev->trg_x ? 1 : 0);
+}
 
-    unsigned long long sent_total = 0;
-    unsigned long long dropped_total = 0;
-    unsigned long long sent_interval = 0;
-    unsigned long long dropped_interval = 0;
-    int counts_interval[MAX_CHANNELS];
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        counts_interval[i] = 0;
+static void write_le(unsigned char *p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+/* Rewrites the 24-bit PPS tick field (word bits 2..25) of a lab subrecord. */
+static void patch_lab_ticks(unsigned char *record, long long t_us) {
+    uint64_t word = read_le(record + 4, 8);
+    uint64_t ticks = (uint64_t)((t_us * 10) % LAB_PPS_TICKS);
+    word = (word & ~(0xFFFFFFULL << 2)) | (ticks << 2);
+    write_le(record + 4, word, 8);
+}
+
+static size_t encode_pool_event(const SimEvent *ev, EventFormat format, char *out) {
+    if (format == EVENT_FORMAT_BINARY) {
+        write_le((unsigned char *)out, (uint32_t)ev->channel, 4);
+        write_le((unsigned char *)out + 4, lab_word(ev), 8);
+        return LAB_SUBRECORD_SIZE;
+    }
+    /* encode_event starts with {"t_us":<digits>; re-encode with a fixed-width field in its place. */
+    char line[EVENT_MAX_LEN];
+    size_t len = encode_event(ev, line);
+    size_t digits_end = POOL_T_US_OFFSET;
+    while (digits_end < len && line[digits_end] != ',') {
+        digits_end++;
+    }
+    memcpy(out, line, POOL_T_US_OFFSET);
+    patch_ndjson_t_us(out + POOL_T_US_OFFSET, ev->t_us);
+    memcpy(out + POOL_T_US_OFFSET + POOL_T_US_WIDTH, line + digits_end, len - digits_end);
+    return POOL_T_US_OFFSET + POOL_T_US_WIDTH + (len - digits_end);
+}
+
+static void build_event_pool(EventPool *pool, const Config *config, const ChannelWeight *weights) {
+    size_t count = config->pool_events;
+    size_t max_len = config->pool_format == EVENT_FORMAT_BINARY ? LAB_SUBRECORD_SIZE : EVENT_MAX_LEN + POOL_T_US_WIDTH;
+    pool->format = config->pool_format;
+    pool->count = count;
+    pool->data = (char *)malloc(count * max_len);
+    pool->offsets = (size_t *)malloc((count + 1) * sizeof(size_t));
+    pool->channels = (uint8_t *)malloc(count);
+    EventBatch *batch = (EventBatch *)malloc(sizeof(EventBatch));
+    if (!pool->data || !pool->offsets || !pool->channels || !batch) {
+        log_printf("Out of memory allocating a %zu-event pool\n", count);
+        exit(1);
+    }
+
+    bool no_burst[MAX_CHANNELS] = {false};
+    init_event_batch(batch, config->channels);
+    build_channel_alias(batch, weights, no_burst, false);
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (batch->next == batch->count) {
+            fill_event_batch(batch, &config->dist, EVENT_BATCH);
+        }
+        SimEvent ev;
+        pool->channels[i] = (uint8_t)next_batch_event(batch, &ev);
+        ev.t_us = 0;
+        ev.channel += config->channel_offset;
+        pool->offsets[i] = len;
+        len += encode_pool_event(&ev, pool->format, pool->data + len);
+    }
+    pool->offsets[count] = len;
+    free(batch);
+}
+
+static void free_event_pool(EventPool *pool) {
+    free(pool->data);
+    free(pool->offsets);
+    free(pool->channels);
+}
+
+static void patch_pool_event(EventPool *pool, size_t index, long long t_us) {
+    char *event = pool->data + pool->offsets[index];
+    if (pool->format == EVENT_FORMAT_BINARY) {
+        patch_lab_ticks((unsigned char *)event, t_us);
+    } else {
+        patch_ndjson_t_us(event + POOL_T_US_OFFSET, t_us);
+    }
+}
+
+/* Writes every byte of iov[0..iovcnt), waiting for writability when the socket is full. */
+static void emitter_writev_all(Emitter *em, struct iovec *iov, int iovcnt) {
+    size_t flushed = 0;
+    size_t pending = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        pending += iov[i].iov_len;
+    }
+    QL_PROBE2(flush_start, 0, pending);
+    while (iovcnt > 0 && !em->failed && !stop_requested) {
+        ssize_t sent = writev(em->fd, iov, iovcnt);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                QL_PROBE2(send_blocked, 0, pending - flushed);
+                emitter_wait_writable(em, 100);
+                continue;
+            }
+            log_printf("writev: %s\n", strerror(errno));
+            em->failed = true;
+            break;
+        }
+        flushed += (size_t)sent;
+        size_t left = (size_t)sent;
+        while (iovcnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    QL_PROBE2(flush_end, flushed, 0);
+}
+
+/* Pool mode under compression: the slice goes out as frames of at most --compress-block bytes. */
+static void emitter_write_compressed(Emitter *em, const struct iovec *iov, int iovcnt) {
+    Compressor *c = &em->compress;
+    for (int i = 0; i < iovcnt && !em->failed && !stop_requested; i++) {
+        const char *bytes = (const char *)iov[i].iov_base;
+        size_t left = iov[i].iov_len;
+        while (left > 0 && !em->failed && !stop_requested) {
+            size_t take = left < c->block_bytes ? left : c->block_bytes;
+            size_t frame = compress_frame(c, bytes, take, c->frame, c->frame_cap);
+            if (frame == 0) {
+                em->failed = true;
+                return;
+            }
+            struct iovec out = {c->frame, frame};
+            emitter_writev_all(em, &out, 1);
+            bytes += take;
+            left -= take;
+        }
+    }
+}
+
+static void run_pool(Emitter *em, const Config *config, EventPool *pool) {
+    double interval_s = 1.0 / config->rate_hz;
+    double interval_ns = interval_s * 1e9;
+    double interval_us = interval_s * 1e6;
+    long long start_ns = em->pacer->timeline->epoch_ns;
+    long long t0_us = now_us() + config->clock_offset_us;
+    unsigned long long first_index = pacer_first_slot(em->pacer, interval_ns);
+    unsigned long long event_index = first_index;
+    size_t cursor = 0;
+
+    while (!stop_requested && !em->failed) {
+        pacer_wait_until(em->pacer, start_ns + (long long)((double)event_index * interval_ns));
+
+        /* Everything already due goes out in one slice, bounded so stats and stop stay responsive. */
+        long long elapsed_ns = pacer_now_ns(em->pacer) - start_ns;
+        unsigned long long due = (unsigned long long)((double)elapsed_ns / interval_ns) + 1;
+        size_t slice = due > event_index ? (size_t)(due - event_index) : 1;
+        if (slice > POOL_SLICE_EVENTS) {
+            slice = POOL_SLICE_EVENTS;
+        }
+        if (slice > pool->count) {
+            slice = pool->count;
+        }
+
+        struct iovec iov[2];
+        int iovcnt = 0;
+        size_t first = cursor;
+        for (size_t k = 0; k < slice; k++) {
+            patch_pool_event(pool, cursor, t0_us + (long long)((double)(event_index - first_index + k) * interval_us));
+            em->counts_interval[pool->channels[cursor]] += 1;
+            if (++cursor == pool->count) {
+                iov[iovcnt].iov_base = pool->data + pool->offsets[first];
+                iov[iovcnt].iov_len = pool->offsets[pool->count] - pool->offsets[first];
+                iovcnt++;
+                cursor = 0;
+                first = 0;
+            }
+        }
+        if (cursor != first) {
+            iov[iovcnt].iov_base = pool->data + pool->offsets[first];
+            iov[iovcnt].iov_len = pool->offsets[cursor] - pool->offsets[first];
+            iovcnt++;
+        }
+        if (em->compress.enabled) {
+            emitter_write_compressed(em, iov, iovcnt);
+        } else {
+            emitter_writev_all(em, iov, iovcnt);
+        }
+        if (!em->failed) {
+            em->sent_total += slice;
+            em->sent_interval += slice;
+        }
+        event_index += slice;
+        emitter_tick(em);
     }
-    print_stats_header();
+}
 
-    char out_buffer[OUT_BUFFER_SIZE];
-    size_t out_len = 0;
+typedef struct {
+    Config config;
+    const Recording *recording;
+    const Timeline *timeline;
+    pthread_t thread;
+    int exit_code;
+} Module;
+
+/* Resolves module index's settings: shared defaults, then --modules spacing, then JSON overrides. */
+static void init_module_config(Config *out, const Config *base, int index) {
+    *out = *base;
+    out->module_index = index;
+    out->port = base->reuseport ? base->port : base->port + index;
+    out->seed = base->seed + (unsigned int)index;
+    out->channel_offset = index * base->channels;
+    out->clock_offset_us = (long long)index * base->module_clock_step_us;
+    if (index >= module_override_count) {
+        return;
+    }
+    const ModuleOverride *mod = &module_overrides[index];
+    if (mod->has_port) out->port = mod->port;
+    if (mod->has_channels) out->channels = mod->channels;
+    if (mod->has_channel_offset) out->channel_offset = mod->channel_offset;
+    if (mod->has_rate_hz) out->rate_hz = mod->rate_hz;
+    if (mod->has_clock_offset) out->clock_offset_us = mod->clock_offset_us;
+    if (mod->has_seed) {
+        out->seed = mod->seed;
+        out->has_seed = true;
+    }
+    if (mod->has_rate_multipliers) {
+        memcpy(out->rate_multipliers, mod->rate_multipliers, sizeof(out->rate_multipliers));
+        out->has_rate_multipliers = true;
+    }
+    if (mod->has_dead_channels) {
+        memcpy(out->dead_channels, mod->dead_channels, sizeof(out->dead_channels));
+    }
+    if (out->channels < 1) out->channels = 1;
+    if (out->channels > MAX_CHANNELS) out->channels = MAX_CHANNELS;
+    if (out->channel_offset < 0) out->channel_offset = 0;
+}
 
+/* Waits for one client while still noticing SIGINT/SIGTERM, which only interrupt the main thread. */
+static int accept_client(int server_fd, struct sockaddr_in *client_addr) {
+    struct pollfd pfd;
+    pfd.fd = server_fd;
+    pfd.events = POLLIN;
     while (!stop_requested) {
-        long long now = now_us();
-        if (config.burst_mode && !burst_active && now >= next_burst_us) {
-            burst_active = true;
-            burst_end_us = now + (long long)BURST_DURATION_S * 1000000LL;
-            choose_burst_channels(burst_channels, config.channels);
-            total_weight = compute_total_weight(weights, config.channels, burst_channels, true);
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, 200);
+        if (ready < 0 && errno != EINTR) {
+            log_printf("poll: %s\n", strerror(errno));
+            return -1;
+        }
+        if (ready <= 0) {
+            continue;
         }
-        if (burst_active && now >= burst_end_us) {
-            burst_active = false;
-            next_burst_us = now + (long long)BURST_INTERVAL_S * 1000000LL;
-            total_weight = compute_total_weight(weights, config.channels, burst_channels, false);
+        socklen_t client_len = sizeof(*client_addr);
+        int client_fd = accept(server_fd, (struct sockaddr *)client_addr, &client_len);
+        if (client_fd >= 0 || (errno != EINTR && errno != EAGAIN)) {
+            return client_fd;
         }
+    }
+    errno = EINTR;
+    return -1;
+}
 
-        int channel = pick_channel(weights, config.channels, total_weight, burst_channels, burst_active);
+/*
+ * With --compress deflate, gives a new client COMPRESS_HELLO_WAIT_MS to ask for compression with a
+ * `QLHELLO compress=deflate` line, and answers COMPRESS_MAGIC if it did. Clients that say nothing
+ * get plain output, so older backends keep working. A hello whose `dict=` CRC-32 differs from
+ * compress_dictionary's also gets plain output: the client could not decode our stream.
+ */
+static bool negotiate_compression(int client_fd) {
+    struct pollfd pfd;
+    pfd.fd = client_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, COMPRESS_HELLO_WAIT_MS) <= 0 || !(pfd.revents & POLLIN)) {
+        return false;
+    }
+    char hello[128];
+    ssize_t got = recv(client_fd, hello, sizeof(hello) - 1, 0);
+    if (got <= 0) {
+        return false;
+    }
+    hello[got] = '\0';
+    if (strncmp(hello, COMPRESS_HELLO, strlen(COMPRESS_HELLO)) != 0 || !strstr(hello, COMPRESS_HELLO_DEFLATE)) {
+        return false;
+    }
+    const char *dict = strstr(hello, COMPRESS_HELLO_DICT);
+    if (dict) {
+        char own[16];
+        snprintf(own, sizeof(own), "%08lx",
+                 crc32(0L, (const Bytef *)compress_dictionary, (uInt)(sizeof(compress_dictionary) - 1)));
+        dict += strlen(COMPRESS_HELLO_DICT);
+        if (strncmp(dict, own, 8) != 0) {
+            log_printf("client dictionary %.8s != %s; sending plain output\n", dict, own);
+            return false;
+        }
+    }
+    return send(client_fd, COMPRESS_MAGIC, strlen(COMPRESS_MAGIC), 0) == (ssize_t)strlen(COMPRESS_MAGIC);
+}
 
-        bool is_g_event = uniform_rand() < config.dist.g_event_prob;
-        bool trg_x = uniform_rand() < config.dist.trg_x_prob;
-        bool trg_g = uniform_rand() < config.dist.trg_g_prob;
-        bool no_data = uniform_rand() < config.dist.no_data_prob;
+/* Runs one emulated detector module: its own listener, client, RNG stream, pacer and emitter. */
+static void *run_module(void *arg) {
+    Module *module = (Module *)arg;
+    Config *config = &module->config;
+    const Recording *recording = module->recording;
+    if (config->modules > 1) {
+        snprintf(log_tag, sizeof(log_tag), "[mod %d] ", config->module_index);
+    }
+    seed_rng(config->has_seed ? config->seed : (uint64_t)time(NULL) + (uint64_t)config->module_index);
 
-        double base_mean = is_g_event ? config.dist.g_mean : config.dist.x_mean;
-        double base_std = is_g_event ? config.dist.g_std : config.dist.x_std;
-        int adc_x = clamp_adc((int)round(normal_rand(base_mean, base_std)));
-        int adc_gtop = clamp_adc((int)round(normal_rand(base_mean + config.dist.gtop_offset, base_std + config.dist.gtop_std_offset)));
-        int adc_gbot = clamp_adc((int)round(normal_rand(base_mean + config.dist.gbot_offset, base_std + config.dist.gbot_std_offset)));
+    ChannelWeight weights[MAX_CHANNELS];
+    double total_weight = 0.0;
+    if (!recording) {
+        init_channel_weights(weights, config);
+        bool no_burst[MAX_CHANNELS] = {false};
+        total_weight = compute_total_weight(weights, config->channels, no_burst, false);
+    }
 
-        if (uniform_rand() < config.dist.low_prob) {
-            adc_x = clamp_adc((int)round(normal_rand(config.dist.low_mean, config.dist.low_std)));
+    int server_fd = setup_server(config->host, config->port, config->reuseport);
+    log_printf("Simulator listening on %s:%d\n", config->host, config->port);
+    if (config->config_path) {
+        log_printf("Config: %s\n", config->config_path);
+    }
+    if (recording) {
+        int channel_offset = config->amplify_channel_offset > 0 ? config->amplify_channel_offset : recording->channel_span;
+        log_printf("Amplifying %s: %zu events, %d channels, %d copies, channel offset %d, speed %.2fx\n",
+            config->amplify_path, recording->count, recording->channel_span, config->amplify_copies,
+            channel_offset, config->amplify_speed);
+    } else {
+        if (config->modules > 1) {
+            log_printf("Channels %d..%d, clock offset %lld us\n", config->channel_offset,
+                config->channel_offset + config->channels - 1, config->clock_offset_us);
         }
-        if (uniform_rand() < config.dist.low_prob) {
-            adc_gtop = clamp_adc((int)round(normal_rand(config.dist.low_mean + 50.0, config.dist.low_std + 10.0)));
+        log_rates(weights, config->channels, config->channel_offset, total_weight, config->rate_hz);
+    }
+    EventPool pool = {NULL, NULL, NULL, 0, EVENT_FORMAT_NDJSON};
+    if (!recording && config->pool_events > 0) {
+        build_event_pool(&pool, config, weights);
+        log_printf("Event pool: %zu %s events, %zu bytes\n", pool.count,
+            pool.format == EVENT_FORMAT_BINARY ? "binary" : "ndjson", pool.offsets[pool.count]);
+    }
+
+    struct sockaddr_in client_addr;
+    int client_fd = accept_client(server_fd, &client_addr);
+    if (client_fd < 0) {
+        if (errno != EINTR) {
+            log_printf("accept: %s\n", strerror(errno));
+            module->exit_code = 1;
         }
-        if (uniform_rand() < config.dist.low_prob) {
-            adc_gbot = clamp_adc((int)round(normal_rand(config.dist.low_mean - 20.0, config.dist.low_std - 10.0)));
+        free_event_pool(&pool);
+        close(server_fd);
+        return NULL;
+    }
+
+    char client_ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
+    log_printf("Client connected: %s:%d\n", client_ip, ntohs(client_addr.sin_port));
+    bool compressed = config->compress && negotiate_compression(client_fd);
+    if (config->compress) {
+        if (compressed) {
+            log_printf("Compression: deflate level %d, block %zu bytes, flush %d ms\n",
+                config->compress_level, config->compress_block, config->compress_flush_ms);
+        } else {
+            log_printf("Compression: client did not ask for it, sending plain output\n");
         }
+    }
+    int fd_flags = fcntl(client_fd, F_GETFL, 0);
+    if (fd_flags < 0 || fcntl(client_fd, F_SETFL, fd_flags | O_NONBLOCK) < 0) {
+        log_printf("fcntl: %s\n", strerror(errno));
+    }
 
-        if (no_data) {
-            adc_x = 0;
-            adc_gtop = 0;
-            adc_gbot = 0;
-        }
-
-        char buffer[512];
-        int len = snprintf(
-            buffer,
-            sizeof(buffer),
-            "{\"t_us\":%lld,\"channel\":%d,\"adc_x\":%d,\"adc_gtop\":%d,\"adc_gbot\":%d,"
-            "\"flags\":{\"trg_x\":%s,\"trg_g\":%s,\"no_data\":%s,\"is_g_event\":%s}}\n",
-            t_us,
-            channel,
-            adc_x,
-            adc_gtop,
-            adc_gbot,
-            trg_x ? "true" : "false",
-            trg_g ? "true" : "false",
-            no_data ? "true" : "false",
-            is_g_event ? "true" : "false");
-
-        bool dropped = uniform_rand() < config.drop_rate;
-        if (!dropped) {
-            if ((size_t)len > sizeof(out_buffer)) {
-                flush_out_buffer(client_fd, out_buffer, &out_len);
-                if (send_all(client_fd, buffer, (size_t)len) < 0) {
-                    perror("send");
-                    break;
-                }
-            } else {
-                if (out_len + (size_t)len > sizeof(out_buffer)) {
-                    flush_out_buffer(client_fd, out_buffer, &out_len);
-                }
-                memcpy(out_buffer + out_len, buffer, (size_t)len);
-                out_len += (size_t)len;
-            }
-            sent_total++;
-            sent_interval++;
-            if (channel >= 0 && channel < config.channels) {
-                counts_interval[channel] += 1;
-            }
+    apply_thread_settings(config);
+    Pacer *pacer = (Pacer *)malloc(sizeof(Pacer));
+    Emitter *emitter = (Emitter *)malloc(sizeof(Emitter));
+    if (!pacer || !emitter) {
+        log_printf("Out of memory allocating module state\n");
+        exit(1);
+    }
+    init_pacer(pacer, config->pacing, module->timeline);
+
+    if (recording) {
+        init_emitter(emitter, client_fd, config, pacer, config->amplify_copies, "mod");
+        if (compressed) {
+            init_compressor(&emitter->compress, config);
+        }
+        print_stats_header("module");
+        run_amplified(emitter, config, recording);
+    } else {
+        init_emitter(emitter, client_fd, config, pacer, config->channels, "ch");
+        if (compressed) {
+            init_compressor(&emitter->compress, config);
+        }
+        emitter->slot_base = config->channel_offset;
+        print_stats_header("channel");
+        if (pool.count > 0) {
+            run_pool(emitter, config, &pool);
         } else {
-            dropped_total++;
-            dropped_interval++;
-        }
-
-        t_us += (long long)(interval_s * 1000000.0);
-
-        struct timespec req;
-        req.tv_sec = (time_t)interval_s;
-        req.tv_nsec = (long)((interval_s - req.tv_sec) * 1e9);
-        nanosleep(&req, NULL);
-
-        long long now_stats = now_us();
-        if (now_stats - last_stats_us >= (long long)config.stats_interval_s * 1000000LL) {
-            double elapsed_s = (now_stats - last_stats_us) / 1000000.0;
-            print_stats(elapsed_s, sent_interval, dropped_interval, counts_interval, config.channels);
-            last_stats_us = now_stats;
-            sent_interval = 0;
-            dropped_interval = 0;
-            for (int i = 0; i < config.channels; i++) {
-                counts_interval[i] = 0;
-            }
-            flush_out_buffer(client_fd, out_buffer, &out_len);
+            run_synthetic(emitter, config, weights);
         }
     }
 
-    flush_out_buffer(client_fd, out_buffer, &out_len);
-    printf("\nFinal summary: sent=%llu dropped=%llu\n", sent_total, dropped_total);
-    printf("Client disconnected\n");
+    emitter_drain(emitter, 1000);
+    log_printf("Final summary: sent=%llu dropped=%llu queue_dropped=%llu queue_dropped_bytes=%llu\n",
+        emitter->sent_total, emitter->dropped_total, emitter->queue_dropped_total, emitter->queue_dropped_bytes_total);
+    if (config->faults.enabled) {
+        char line[512];
+        int len = snprintf(line, sizeof(line), "Injected faults:");
+        for (int k = FAULT_NONE + 1; k < FAULT_KINDS && len > 0 && len < (int)sizeof(line); k++) {
+            len += snprintf(line + len, sizeof(line) - (size_t)len, " %s=%llu", fault_names[k], emitter->fault_totals[k]);
+        }
+        log_printf("%s\n", line);
+    }
+    if (emitter->compress.enabled) {
+        const Compressor *c = &emitter->compress;
+        log_printf("Compression summary: raw_bytes=%llu wire_bytes=%llu ratio=%.2f cpu_ms=%.1f\n",
+            c->raw_total, c->wire_total, c->wire_total ? (double)c->raw_total / (double)c->wire_total : 0.0,
+            c->cpu_ns_total / 1e6);
+    }
+    log_printf("Client disconnected\n");
+    free_compressor(&emitter->compress);
+    free_output_queue(&emitter->queue);
+    free(emitter->fault_buffer);
+    free(emitter);
+    free(pacer);
+    free_event_pool(&pool);
+    /* Discard an unanswered compression hello so the close is not turned into a reset. */
+    char discard[128];
+    while (recv(client_fd, discard, sizeof(discard), MSG_DONTWAIT) > 0) {
+    }
     close(client_fd);
     close(server_fd);
-    return 0;
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    static Config config;
+    parse_args(argc, argv, &config);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    Recording recording = {NULL, 0, 0};
+    if (config.amplify_path) {
+        load_recording(&config, &recording);
+    }
+    if (!config.has_seed) {
+        config.seed = (unsigned int)time(NULL);
+        config.has_seed = true;
+    }
+    apply_mlockall(&config);
+    if (!config.amplify_path) {
+        init_normal_table();
+    }
+
+    static Timeline timeline;
+    init_timeline(&timeline, config.pacing);
+    static Module modules[MAX_MODULES];
+    for (int m = 0; m < config.modules; m++) {
+        init_module_config(&modules[m].config, &config, m);
+        modules[m].recording = config.amplify_path ? &recording : NULL;
+        modules[m].timeline = &timeline;
+        modules[m].exit_code = 0;
+    }
+
+    int exit_code = 0;
+    if (config.modules == 1) {
+        run_module(&modules[0]);
+        exit_code = modules[0].exit_code;
+    } else {
+        printf("Starting %d modules%s\n", config.modules, config.reuseport ? " (SO_REUSEPORT)" : "");
+        for (int m = 0; m < config.modules; m++) {
+            if (pthread_create(&modules[m].thread, NULL, run_module, &modules[m]) != 0) {
+                perror("pthread_create");
+                stop_requested = 1;
+                config.modules = m;
+                break;
+            }
+        }
+        for (int m = 0; m < config.modules; m++) {
+            pthread_join(modules[m].thread, NULL);
+            if (modules[m].exit_code != 0) {
+                exit_code = modules[m].exit_code;
+            }
+        }
+    }
+
+    free(recording.events);
+    return exit_code;
 }
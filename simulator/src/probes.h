@@ -0,0 +1,31 @@
+#ifndef QL_PROBES_H
+#define QL_PROBES_H
+
+/*
+ * USDT probes for perf / bpftrace, provider "quicklook". Built with -DQL_USDT (make
+ * simulator-profile) they become <sys/sdt.h> markers: a single nop at the probe site plus an ELF
+ * note, so they cost nothing until a tracer attaches. Without QL_USDT, or without sdt.h
+ * (systemtap-sdt-dev / systemtap-sdt-devel), they compile to nothing.
+ *
+ *   bpftrace -l 'usdt:./simulator/simulator:quicklook:*'
+ */
+#if defined(QL_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define QL_PROBES_ENABLED 1
+#else
+#warning "sys/sdt.h not found; USDT probes are compiled out"
+#endif
+#endif
+
+#ifdef QL_PROBES_ENABLED
+#define QL_PROBE1(name, a) DTRACE_PROBE1(quicklook, name, a)
+#define QL_PROBE2(name, a, b) DTRACE_PROBE2(quicklook, name, a, b)
+#define QL_PROBE3(name, a, b, c) DTRACE_PROBE3(quicklook, name, a, b, c)
+#else
+#define QL_PROBE1(name, a) do { (void)(a); } while (0)
+#define QL_PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#define QL_PROBE3(name, a, b, c) do { (void)(a); (void)(b); (void)(c); } while (0)
+#endif
+
+#endif
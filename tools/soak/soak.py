@@ -0,0 +1,355 @@
+#!/usr/bin/env python3
+"""Long-duration soak test: simulator -> backend, sampled into a time series with trend checks.
+
+Starts the simulator and a backend (uvicorn) as child processes, starts acquisition, and every
+--interval seconds records RSS, open FDs, threads and CPU of both processes, `/snapshot` and
+`/status` latency, ingest lag and recording size into a CSV. At the end (or on Ctrl-C) it fits a
+least-squares slope per hour to each tracked series after --warmup and fails when one grows
+faster than its threshold.
+"""
+
+from __future__ import annotations
+
+import argparse
+import csv
+import json
+import os
+import shlex
+import signal
+import subprocess
+import sys
+import time
+import urllib.error
+import urllib.request
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+CLOCK_TICKS = os.sysconf("SC_CLK_TCK")
+
+COLUMNS = [
+    "elapsed_s",
+    "backend_rss_mb",
+    "backend_fds",
+    "backend_threads",
+    "backend_cpu_pct",
+    "sim_rss_mb",
+    "sim_cpu_pct",
+    "snapshot_ms",
+    "status_ms",
+    "snapshot_bytes",
+    "lag_s",
+    "record_mb",
+    "connected",
+]
+
+# Series checked for growth: column -> (argument holding the limit, unit for the report).
+TRENDS = {
+    "backend_rss_mb": ("max_rss_mb_per_h", "MB/h"),
+    "backend_fds": ("max_fds_per_h", "FDs/h"),
+    "backend_threads": ("max_threads_per_h", "threads/h"),
+    "snapshot_ms": ("max_latency_ms_per_h", "ms/h"),
+    "lag_s": ("max_lag_s_per_h", "s/h"),
+}
+
+# Columns left NaN when a sample's HTTP probes fail.
+PROBED = ("snapshot_ms", "status_ms", "lag_s")
+
+
+def parse_duration(text: str) -> float:
+    """`90`, `90s`, `15m`, `2h` or `3d` -> seconds."""
+    units = {"s": 1, "m": 60, "h": 3600, "d": 86400}
+    if text and text[-1] in units:
+        return float(text[:-1]) * units[text[-1]]
+    return float(text)
+
+
+def http_get(url: str) -> Tuple[float, bytes]:
+    """(milliseconds, body)."""
+    start = time.perf_counter()
+    with urllib.request.urlopen(url, timeout=10) as response:
+        body = response.read()
+    return (time.perf_counter() - start) * 1000.0, body
+
+
+def http_post(url: str) -> dict:
+    req = urllib.request.Request(url, method="POST")
+    with urllib.request.urlopen(req, timeout=10) as response:
+        return json.loads(response.read().decode("utf-8"))
+
+
+class ProcessSampler:
+    """RSS, FDs, threads and CPU of one process from /proc (Linux)."""
+
+    def __init__(self, pid: int) -> None:
+        self.pid = pid
+        self.last_cpu_ticks: Optional[int] = None
+        self.last_wall = time.monotonic()
+
+    def sample(self) -> Dict[str, float]:
+        status: Dict[str, str] = {}
+        with open(f"/proc/{self.pid}/status", "r", encoding="utf-8") as status_fp:
+            for line in status_fp:
+                key, _, value = line.partition(":")
+                status[key] = value.strip()
+        with open(f"/proc/{self.pid}/stat", "r", encoding="utf-8") as stat_fp:
+            # Fields after the parenthesised command name; utime and stime are fields 14 and 15.
+            fields = stat_fp.read().rpartition(")")[2].split()
+        cpu_ticks = int(fields[11]) + int(fields[12])
+        now = time.monotonic()
+        cpu_pct = 0.0
+        if self.last_cpu_ticks is not None and now > self.last_wall:
+            cpu_pct = 100.0 * (cpu_ticks - self.last_cpu_ticks) / CLOCK_TICKS / (now - self.last_wall)
+        self.last_cpu_ticks, self.last_wall = cpu_ticks, now
+        return {
+            "rss_mb": int(status.get("VmRSS", "0 kB").split()[0]) / 1024.0,
+            "fds": float(len(os.listdir(f"/proc/{self.pid}/fd"))),
+            "threads": float(status.get("Threads", "0")),
+            "cpu_pct": cpu_pct,
+        }
+
+
+def slope_per_hour(times: List[float], values: List[float]) -> float:
+    n = len(times)
+    if n < 3:
+        return 0.0
+    mean_t = sum(times) / n
+    mean_v = sum(values) / n
+    var_t = sum((t - mean_t) ** 2 for t in times)
+    if var_t == 0:
+        return 0.0
+    cov = sum((t - mean_t) * (v - mean_v) for t, v in zip(times, values))
+    return cov / var_t * 3600.0
+
+
+def summarize(rows: List[Dict[str, float]], args: argparse.Namespace) -> Dict[str, object]:
+    steady = [row for row in rows if row["elapsed_s"] >= args.warmup]
+    times = [row["elapsed_s"] for row in steady]
+    # A slope fitted over a few minutes extrapolates start-up noise to an hour; only judge long runs.
+    judged = len(times) >= 3 and times[-1] - times[0] >= args.min_trend_span
+    trends: Dict[str, Dict[str, object]] = {}
+    failed = False
+    for column, (limit_name, unit) in TRENDS.items():
+        # Drop a failed sample's time together with its NaN value so the fit still covers the run.
+        points = [(row["elapsed_s"], row[column]) for row in steady if row[column] == row[column]]
+        values = [value for _, value in points]
+        limit = getattr(args, limit_name)
+        slope = slope_per_hour([t for t, _ in points], values)
+        over = judged and limit >= 0 and slope > limit
+        failed = failed or over
+        trends[column] = {
+            "first": round(values[0], 3) if values else None,
+            "last": round(values[-1], 3) if values else None,
+            "max": round(max(values), 3) if values else None,
+            "slope_per_h": round(slope, 3),
+            "limit_per_h": limit,
+            "unit": unit,
+            "ok": not over,
+        }
+    failed_samples = sum(1 for row in steady if any(row[column] != row[column] for column in PROBED))
+    if args.max_failed_fraction >= 0 and failed_samples > args.max_failed_fraction * len(steady):
+        failed = True
+    latencies = sorted(row["snapshot_ms"] for row in steady if row["snapshot_ms"] == row["snapshot_ms"])
+    return {
+        "duration_s": rows[-1]["elapsed_s"] if rows else 0.0,
+        "samples": len(rows),
+        "steady_samples": len(steady),
+        "snapshot_ms_p50": round(latencies[len(latencies) // 2], 2) if latencies else None,
+        "snapshot_ms_p99": round(latencies[min(len(latencies) - 1, int(len(latencies) * 0.99))], 2) if latencies else None,
+        "trends_judged": judged,
+        "disconnected_samples": sum(1 for row in steady if not row["connected"]),
+        "failed_samples": failed_samples,
+        "trends": trends,
+        "failed": failed,
+    }
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Quicklook soak test with memory, FD and latency trend checks")
+    parser.add_argument("--duration", type=parse_duration, default=parse_duration("10m"), help="e.g. 600, 30m, 48h")
+    parser.add_argument("--interval", type=float, default=5.0, help="seconds between samples")
+    parser.add_argument("--warmup", type=parse_duration, default=parse_duration("2m"), help="ignored by trend checks")
+    parser.add_argument(
+        "--min-trend-span", type=parse_duration, default=parse_duration("10m"), help="shorter steady phases are reported only"
+    )
+    parser.add_argument("--out", type=Path, default=Path("soak.csv"), help="CSV time series, written as it runs")
+    parser.add_argument("--summary", type=Path, help="also write the summary as JSON here")
+    parser.add_argument("--rate-hz", type=float, default=20000.0, help="simulator event rate")
+    parser.add_argument("--channels", type=int, default=64)
+    parser.add_argument("--sim-args", default="", help="extra simulator arguments, e.g. '--burst-mode on'")
+    parser.add_argument("--sim-port", type=int, default=9101)
+    parser.add_argument("--backend-port", type=int, default=8100)
+    parser.add_argument("--window-s", type=int, default=2, help="short windows compress many window cycles into the run")
+    parser.add_argument("--sample-s", type=int, default=1)
+    parser.add_argument("--record", type=Path, help="run the backend in record mode to this file, tracking its size")
+    parser.add_argument("--backend-env", action="append", default=[], help="extra NAME=VALUE for the backend")
+    parser.add_argument("--max-rss-mb-per-h", type=float, default=20.0)
+    parser.add_argument("--max-fds-per-h", type=float, default=2.0)
+    parser.add_argument("--max-threads-per-h", type=float, default=2.0)
+    parser.add_argument("--max-latency-ms-per-h", type=float, default=5.0)
+    parser.add_argument("--max-lag-s-per-h", type=float, default=1.0, help="-1 disables (e.g. with --amplify)")
+    parser.add_argument(
+        "--max-failed-fraction", type=float, default=0.01, help="steady samples whose HTTP probes may fail; -1 disables"
+    )
+    return parser.parse_args()
+
+
+def main() -> int:
+    args = parse_args()
+    base_url = f"http://127.0.0.1:{args.backend_port}"
+    simulator = REPO_ROOT / "simulator" / "simulator"
+    if not simulator.exists():
+        print("simulator/simulator not built; run `make simulator`", file=sys.stderr)
+        return 2
+
+    sim_cmd = [
+        str(simulator),
+        "--port", str(args.sim_port),
+        "--rate-hz", str(args.rate_hz),
+        "--channels", str(args.channels),
+        "--stats-interval", "60",
+    ] + shlex.split(args.sim_args)
+    backend_env = dict(os.environ)
+    backend_env.update(
+        SIM_PORT=str(args.sim_port),
+        CHANNELS=str(args.channels),
+        WINDOW_S=str(args.window_s),
+        SAMPLE_S=str(args.sample_s),
+        QUICKLOOK_MODE="record" if args.record else "live",
+    )
+    if args.record:
+        backend_env["QUICKLOOK_RECORD_PATH"] = str(args.record)
+    for item in args.backend_env:
+        name, _, value = item.partition("=")
+        backend_env[name] = value
+    backend_cmd = [
+        sys.executable, "-m", "uvicorn", "backend.src.main:app",
+        "--host", "127.0.0.1", "--port", str(args.backend_port), "--log-level", "warning",
+    ]
+
+    sim_log = open(args.out.with_suffix(".simulator.log"), "w", encoding="utf-8")
+    backend_log = open(args.out.with_suffix(".backend.log"), "w", encoding="utf-8")
+    sim_proc = subprocess.Popen(sim_cmd, cwd=REPO_ROOT, stdout=sim_log, stderr=subprocess.STDOUT)
+    backend_proc = subprocess.Popen(backend_cmd, cwd=REPO_ROOT, env=backend_env, stdout=backend_log, stderr=subprocess.STDOUT)
+    print(f"[soak] simulator pid {sim_proc.pid}, backend pid {backend_proc.pid}, {args.duration:.0f} s", file=sys.stderr)
+
+    stop = False
+
+    def request_stop(signum, frame) -> None:
+        nonlocal stop
+        stop = True
+
+    signal.signal(signal.SIGINT, request_stop)
+    signal.signal(signal.SIGTERM, request_stop)
+
+    rows: List[Dict[str, float]] = []
+    died: Optional[str] = None
+    try:
+        for _ in range(100):
+            try:
+                http_post(f"{base_url}/start")
+                break
+            except (urllib.error.URLError, OSError):
+                time.sleep(0.1)
+        else:
+            died = "backend did not come up"
+        backend_sampler = ProcessSampler(backend_proc.pid)
+        sim_sampler = ProcessSampler(sim_proc.pid)
+        started = time.monotonic()
+        next_sample = started
+        with open(args.out, "w", newline="", encoding="utf-8") as out_fp:
+            writer = csv.DictWriter(out_fp, fieldnames=COLUMNS)
+            writer.writeheader()
+            while died is None and not stop and time.monotonic() - started < args.duration:
+                next_sample += args.interval
+                time.sleep(max(0.0, next_sample - time.monotonic()))
+                if backend_proc.poll() is not None:
+                    died = f"backend exited with {backend_proc.returncode}"
+                    break
+                if sim_proc.poll() is not None:
+                    died = f"simulator exited with {sim_proc.returncode}"
+                    break
+                row = sample(args, base_url, backend_sampler, sim_sampler, started)
+                rows.append(row)
+                writer.writerow({key: round(value, 3) if isinstance(value, float) else value for key, value in row.items()})
+                out_fp.flush()
+    finally:
+        for proc in (backend_proc, sim_proc):
+            if proc.poll() is None:
+                proc.terminate()
+                try:
+                    proc.wait(timeout=10)
+                except subprocess.TimeoutExpired:
+                    proc.kill()
+        sim_log.close()
+        backend_log.close()
+
+    summary = summarize(rows, args)
+    if died:
+        summary["failed"] = True
+        summary["error"] = died
+    print(json.dumps(summary, indent=2))
+    if args.summary:
+        args.summary.write_text(json.dumps(summary, indent=2) + "\n", encoding="utf-8")
+    for column, trend in summary["trends"].items():
+        if not trend["ok"]:
+            print(
+                f"[soak] FAIL {column} grows {trend['slope_per_h']} {trend['unit']} (limit {trend['limit_per_h']})",
+                file=sys.stderr,
+            )
+    if died:
+        print(f"[soak] FAIL {died}", file=sys.stderr)
+    if args.max_failed_fraction >= 0 and summary["failed_samples"] > args.max_failed_fraction * summary["steady_samples"]:
+        print(
+            f"[soak] FAIL {summary['failed_samples']} of {summary['steady_samples']} samples failed "
+            f"(limit {args.max_failed_fraction:.2%})",
+            file=sys.stderr,
+        )
+    if not summary["trends_judged"]:
+        print(f"[soak] steady phase shorter than {args.min_trend_span:.0f} s; trends not judged", file=sys.stderr)
+    print(f"[soak] {'FAIL' if summary['failed'] else 'PASS'}; time series in {args.out}", file=sys.stderr)
+    return 1 if summary["failed"] else 0
+
+
+def sample(
+    args: argparse.Namespace,
+    base_url: str,
+    backend_sampler: ProcessSampler,
+    sim_sampler: ProcessSampler,
+    started: float,
+) -> Dict[str, float]:
+    backend = backend_sampler.sample()
+    sim = sim_sampler.sample()
+    nan = float("nan")
+    snapshot_ms, status_ms, snapshot_bytes, lag_s, connected = nan, nan, 0, nan, 0
+    try:
+        snapshot_ms, body = http_get(f"{base_url}/snapshot")
+        snapshot_bytes = len(body)
+        t_end_us = json.loads(body).get("t_end_us", 0)
+        # The simulator stamps events with CLOCK_MONOTONIC, like time.monotonic() on Linux.
+        if t_end_us:
+            lag_s = time.monotonic() - t_end_us / 1_000_000.0
+        status_ms, body = http_get(f"{base_url}/status")
+        connected = int(bool(json.loads(body).get("connected")))
+    except (urllib.error.URLError, OSError, ValueError) as exc:
+        print(f"[soak] sample failed: {exc}", file=sys.stderr)
+    record_mb = args.record.stat().st_size / 1e6 if args.record and args.record.exists() else 0.0
+    return {
+        "elapsed_s": time.monotonic() - started,
+        "backend_rss_mb": backend["rss_mb"],
+        "backend_fds": backend["fds"],
+        "backend_threads": backend["threads"],
+        "backend_cpu_pct": backend["cpu_pct"],
+        "sim_rss_mb": sim["rss_mb"],
+        "sim_cpu_pct": sim["cpu_pct"],
+        "snapshot_ms": snapshot_ms,
+        "status_ms": status_ms,
+        "snapshot_bytes": snapshot_bytes,
+        "lag_s": lag_s,
+        "record_mb": record_mb,
+        "connected": connected,
+    }
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())